@@ -0,0 +1,195 @@
+/*
+ * Benchmark.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#include "Benchmark.h"
+#include "DetectorProfiles.h"
+#include "TargetDetector.h"
+#include "ThresholdPipeline.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <opencv2/imgproc.hpp>
+
+// Repetitions each timing is averaged over.
+static const int BENCH_RUNS = 20;
+
+static const cv::Scalar benchLower(50, 100, 100);
+static const cv::Scalar benchUpper(90, 255, 255);
+
+// Noise with a few green targets, so every stage has real work to do.
+static cv::Mat syntheticFrame(cv::Size size) {
+	cv::Mat frame(size, CV_8UC4);
+	cv::RNG rng(size.area());
+	rng.fill(frame, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+
+	for (int i = 0; i < 12; i++) {
+		cv::Point centre(rng.uniform(0, size.width), rng.uniform(0, size.height));
+		int radius = rng.uniform(size.height / 40, size.height / 8);
+		if (i % 2)
+			cv::circle(frame, centre, radius, cv::Scalar(40, 220, 60, 255), -1);
+		else
+			cv::rectangle(frame, cv::Rect(centre.x, centre.y, radius * 2, radius), cv::Scalar(30, 200, 40, 255), -1);
+	}
+	return frame;
+}
+
+static void serialThreshold(const cv::Mat &frame, int passes, cv::Mat &threshold) {
+	cv::Mat hsv;
+	cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
+	inRange(hsv, benchLower, benchUpper, threshold);
+	morphOps(threshold, passes, 1.0);
+}
+
+static int countContours(const cv::Mat &threshold) {
+	cv::Mat temp;
+	threshold.copyTo(temp);
+	std::vector<std::vector<cv::Point> > contours;
+	std::vector<cv::Vec4i> hierarchy;
+	findContours(temp, contours, hierarchy, CV_RETR_CCOMP, CV_CHAIN_APPROX_SIMPLE);
+	return contours.size();
+}
+
+template <class F>
+static double timeMs(F run) {
+	run();	// Warm up, allocates the buffers.
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < BENCH_RUNS; i++)
+		run();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / BENCH_RUNS;
+}
+
+struct SerialRun {
+	const cv::Mat &frame;
+	int passes;
+	cv::Mat &threshold;
+	void operator()() const {serialThreshold(frame, passes, threshold);}
+};
+
+struct ParallelRun {
+	ParallelThreshold &parallel;
+	const cv::Mat &frame;
+	int passes;
+	cv::Mat &threshold;
+	void operator()() const {parallel.process(frame, benchLower, benchUpper, passes, 1.0, threshold);}
+};
+
+struct ContourRun {
+	const cv::Mat &threshold;
+	void operator()() const {countContours(threshold);}
+};
+
+struct LabelRun {
+	const cv::Mat &threshold;
+	std::vector<Blob> &blobs;
+	void operator()() const {labelBlobs(threshold, blobs);}
+};
+
+struct GenericVariantRun {
+	const DetectorVariant &variant;
+	const cv::Mat &frame;
+	double scale;
+	cv::Mat &hsv;
+	cv::Mat &threshold;
+	Target &target;
+	TargetStatus &status;
+	void operator()() const {
+		thresholdGeneric(variant, frame, benchLower, benchUpper, hsv, threshold);
+		status = findTargetGeneric(variant, threshold, scale, target);
+	}
+};
+
+struct SpecialisedVariantRun {
+	const DetectorVariant &variant;
+	const cv::Mat &frame;
+	double scale;
+	cv::Mat &hsv;
+	cv::Mat &threshold;
+	Target &target;
+	TargetStatus &status;
+	void operator()() const {
+		variant.threshold(frame, benchLower, benchUpper, hsv, threshold);
+		status = variant.find(threshold, scale, target);
+	}
+};
+
+bool runThresholdBenchmark() {
+	const cv::Size sizes[] = {cv::Size(1280, 720), cv::Size(1920, 1080)};
+	int saved_threads = cv::getNumThreads();
+	int max_threads = cv::getNumberOfCPUs();
+	bool identical = true;
+
+	for (int s = 0; s < 2; s++) {
+		cv::Mat frame = syntheticFrame(sizes[s]);
+		ParallelThreshold parallel;
+		std::vector<Blob> blobs;
+
+		// Both pass counts of the quality ladder, each has its own morphHalo.
+		for (int passes = 1; passes <= 2; passes++) {
+			cv::Mat serial, parallel_thresh;
+
+			cv::setNumThreads(1);
+			double serial_ms = timeMs(SerialRun {frame, passes, serial});
+			double contour_ms = timeMs(ContourRun {serial});
+
+			std::printf("%dx%d, %d passes, %d blobs, serial threshold %.2fms, findContours %.2fms\n", sizes[s].width,
+					sizes[s].height, passes, countContours(serial), serial_ms, contour_ms);
+			// labelBlobs and findContours do different work (pixel counts against contour areas,
+			// no holes), so that column only compares their times.
+			std::printf("threads  threshold   speedup  labelBlobs  findContours/labelBlobs\n");
+
+			for (int t = 1; t <= max_threads; t++) {
+				cv::setNumThreads(t);
+				double parallel_ms = timeMs(ParallelRun {parallel, frame, passes, parallel_thresh});
+				double label_ms = timeMs(LabelRun {serial, blobs});
+
+				bool same = cv::countNonZero(serial != parallel_thresh) == 0;
+				identical = identical && same;
+				std::printf("%7d  %7.2fms  %7.2fx  %8.2fms  %22.2fx%s\n", t, parallel_ms, serial_ms / parallel_ms,
+						label_ms, contour_ms / label_ms, same ? "" : "  MISMATCH");
+			}
+			std::printf("\n");
+		}
+	}
+
+	cv::setNumThreads(saved_threads);
+	return identical;
+}
+
+bool runProfileBenchmark() {
+	int saved_threads = cv::getNumThreads();
+	int count;
+	const DetectorVariant *variants = getDetectorVariants(count);
+	cv::Mat frame = syntheticFrame(cv::Size(1280, 720));
+	bool identical = true;
+
+	// One thread, so the comparison is the kernels and not OpenCV's own parallel loops.
+	cv::setNumThreads(1);
+	std::printf("profile     passes  scale   generic  specialised  speedup\n");
+
+	for (int i = 0; i < count; i++) {
+		const DetectorVariant &variant = variants[i];
+		cv::Mat scaled, hsv, generic_thresh, specialised_thresh;
+		Target generic_target, specialised_target;
+		TargetStatus generic_status, specialised_status;
+
+		// Scaled down the way the main loop does it.
+		double scale = variant.scale_percent / 100.0;
+		cv::resize(frame, scaled, cv::Size(), scale, scale, cv::INTER_NEAREST);
+
+		double generic_ms = timeMs(GenericVariantRun {variant, scaled, scale, hsv, generic_thresh, generic_target, generic_status});
+		double specialised_ms = timeMs(SpecialisedVariantRun {variant, scaled, scale, hsv, specialised_thresh, specialised_target, specialised_status});
+
+		bool same = cv::countNonZero(generic_thresh != specialised_thresh) == 0 && generic_status == specialised_status
+				&& (generic_status != TARGET_FOUND || generic_target.centroid == specialised_target.centroid);
+		identical = identical && same;
+		std::printf("%-10s  %6d  %4d%%  %6.2fms  %9.2fms  %6.2fx%s\n", variant.profile, variant.passes, variant.scale_percent, generic_ms, specialised_ms,
+				generic_ms / specialised_ms, same ? "" : "  MISMATCH");
+	}
+
+	cv::setNumThreads(saved_threads);
+	return identical;
+}
@@ -0,0 +1,21 @@
+/*
+ * Benchmark.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+// Time the serial threshold path against ParallelThreshold with 1 and 2 morphology passes, and
+// compare the time of labelBlobs with findContours, at 720p and 1080p for 1 up to the number of
+// cores threads. Runs on synthetic frames so no camera is needed. Returns false if a parallel
+// result differs from the serial one.
+bool runThresholdBenchmark();
+
+// Time every specialised detector variant against the generic path with the same settings, on
+// one thread on a 720p frame scaled to the processing scale of the variant. Returns false if a variant's threshold image or target differs.
+bool runProfileBenchmark();
+
+#endif /* BENCHMARK_H_ */
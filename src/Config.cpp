@@ -0,0 +1,123 @@
+/*
+ * Config.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#include "Config.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static std::string trim(const std::string &s) {
+	size_t start = s.find_first_not_of(" \t\r\n");
+	if (start == std::string::npos)
+		return "";
+	size_t end = s.find_last_not_of(" \t\r\n");
+	return s.substr(start, end - start + 1);
+}
+
+Config::Config() {
+}
+
+Config::~Config() {
+}
+
+bool Config::load(const std::string &path) {
+	std::ifstream file(path.c_str());
+	if (!file) {
+		std::cout << "Cannot open config file " << path << std::endl;
+		return false;
+	}
+
+	std::string line;
+	int line_number = 0;
+	while (std::getline(file, line)) {
+		line_number++;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+			line.erase(comment);
+		line = trim(line);
+		if (line.empty())
+			continue;
+
+		size_t equals = line.find('=');
+		if (equals == std::string::npos) {
+			std::cout << path << ":" << line_number << ": expected key = value" << std::endl;
+			continue;
+		}
+		set(trim(line.substr(0, equals)), trim(line.substr(equals + 1)));
+	}
+
+	std::cout << "Loaded config file " << path << std::endl;
+	return true;
+}
+
+bool Config::parseArgs(int argc, char **argv) {
+	bool ok = true;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+
+		// Any other argument turns on calibration mode, as it always has.
+		if (arg.compare(0, 2, "--") != 0) {
+			set("calibrate", "true");
+			continue;
+		}
+
+		arg.erase(0, 2);
+		std::string key = arg, value = "true";
+		size_t equals = arg.find('=');
+		if (equals != std::string::npos) {
+			key = arg.substr(0, equals);
+			value = arg.substr(equals + 1);
+		}
+
+		if (key == "config")
+			ok = load(value) && ok;
+		else
+			set(key, value);
+	}
+	return ok;
+}
+
+bool Config::has(const std::string &key) {
+	return values.find(key) != values.end();
+}
+
+void Config::set(const std::string &key, const std::string &value) {
+	values[key] = value;
+}
+
+std::string Config::getString(const std::string &key, const std::string &def) {
+	std::map<std::string, std::string>::iterator it = values.find(key);
+	return it == values.end() ? def : it->second;
+}
+
+int Config::getInt(const std::string &key, int def) {
+	return has(key) ? std::atoi(values[key].c_str()) : def;
+}
+
+double Config::getDouble(const std::string &key, double def) {
+	return has(key) ? std::atof(values[key].c_str()) : def;
+}
+
+bool Config::getBool(const std::string &key, bool def) {
+	if (!has(key))
+		return def;
+	const std::string &v = values[key];
+	return v == "true" || v == "1" || v == "yes" || v == "on";
+}
+
+std::vector<double> Config::getDoubles(const std::string &key) {
+	std::vector<double> result;
+	std::stringstream ss(getString(key, ""));
+	std::string item;
+	while (std::getline(ss, item, ',')) {
+		item = trim(item);
+		if (!item.empty())
+			result.push_back(std::atof(item.c_str()));
+	}
+	return result;
+}
@@ -0,0 +1,41 @@
+/*
+ * Config.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Settings from a config file of "key = value" lines ('#' starts a comment) and from
+// "--key=value" command line options, "--key" on its own means "--key=true". Later values
+// override earlier ones, so options given after --config=<file> win over the file.
+class Config {
+public:
+	Config();
+	virtual ~Config();
+
+	bool load(const std::string &path);
+	// Returns false if an option could not be used, e.g. a config file that does not exist.
+	bool parseArgs(int argc, char **argv);
+
+	bool has(const std::string &key);
+	void set(const std::string &key, const std::string &value);
+
+	std::string getString(const std::string &key, const std::string &def);
+	int getInt(const std::string &key, int def);
+	double getDouble(const std::string &key, double def);
+	bool getBool(const std::string &key, bool def);
+	// Comma separated list, empty if the key is not set.
+	std::vector<double> getDoubles(const std::string &key);
+
+private:
+	std::map<std::string, std::string> values;
+};
+
+#endif /* CONFIG_H_ */
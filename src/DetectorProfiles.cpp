@@ -0,0 +1,95 @@
+/*
+ * DetectorProfiles.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#include "DetectorProfiles.h"
+#include <vector>
+
+// morphOps with the kernels and pass count of a profile, fixed at compile time. Kernels are
+// scaled to the processing scale like morphOps does. The elements are built on the first call.
+template <class P, int Passes, int Percent>
+static void morphProfile(cv::Mat &mask) {
+	const int erode = scaledKernelSizePercent(P::erode_size, Percent);
+	const int dilate = scaledKernelSizePercent(P::dilate_size, Percent);
+	static const cv::Mat erodeElement = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(erode, erode));
+	static const cv::Mat dilateElement = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(dilate, dilate));
+
+	for (int i = 0; i < Passes; i++)
+		cv::erode(mask, mask, erodeElement);
+	for (int i = 0; i < Passes; i++)
+		cv::dilate(mask, mask, dilateElement);
+}
+
+template <class P, int Passes, int Percent>
+static void thresholdProfile(const cv::Mat &frame, cv::Scalar lower, cv::Scalar upper, cv::Mat &hsv, cv::Mat &threshold) {
+	cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
+	inRange(hsv, lower, upper, threshold);
+	morphProfile<P, Passes, Percent>(threshold);
+}
+
+template <class P>
+static TargetStatus findTargetProfile(const cv::Mat &threshold, double scale, Target &target) {
+	ContourBuffers &buffers = contourBuffers();
+	threshold.copyTo(buffers.temp);
+	findContours(buffers.temp, buffers.contours, buffers.hierarchy, P::retrieval, cv::CHAIN_APPROX_SIMPLE);
+
+	if (P::strips == 2)
+		return selectStripPair(buffers.contours, buffers.hierarchy, scale, P(), target);
+	return selectTarget(buffers.contours, buffers.hierarchy, scale, P(), target);
+}
+
+#define DETECTOR_VARIANT(name, P, passes, percent) \
+	{name, passes, percent, thresholdProfile<P, passes, percent>, findTargetProfile<P>, \
+	scaledKernelSizePercent(P::erode_size, percent), scaledKernelSizePercent(P::dilate_size, percent), \
+	P::retrieval, P::strips, {P::max_objects, P::min_area, P::max_area}}
+
+// Every pass count and processing scale of the quality ladder.
+#define PROFILE_VARIANTS(name, P) \
+	DETECTOR_VARIANT(name, P, 1, 100), DETECTOR_VARIANT(name, P, 2, 100), \
+	DETECTOR_VARIANT(name, P, 1, 75), DETECTOR_VARIANT(name, P, 2, 75), \
+	DETECTOR_VARIANT(name, P, 1, 50), DETECTOR_VARIANT(name, P, 2, 50)
+
+static const DetectorVariant variants[] = {
+	PROFILE_VARIANTS("high_goal", HighGoalProfile),
+	PROFILE_VARIANTS("gear_peg", GearPegProfile),
+};
+
+static const int num_variants = sizeof(variants) / sizeof(variants[0]);
+
+const DetectorVariant *findDetectorVariant(const std::string &profile, int passes, double scale) {
+	int percent = cvRound(scale * 100);
+	for (int i = 0; i < num_variants; i++)
+		if (profile == variants[i].profile && passes == variants[i].passes && percent == variants[i].scale_percent)
+			return &variants[i];
+	return NULL;
+}
+
+const DetectorVariant *getDetectorVariants(int &count) {
+	count = num_variants;
+	return variants;
+}
+
+void thresholdGeneric(const DetectorVariant &variant, const cv::Mat &frame, cv::Scalar lower, cv::Scalar upper, cv::Mat &hsv, cv::Mat &threshold) {
+	cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
+	inRange(hsv, lower, upper, threshold);
+
+	cv::Mat erodeElement = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(variant.erode_size, variant.erode_size));
+	cv::Mat dilateElement = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(variant.dilate_size, variant.dilate_size));
+	for (int i = 0; i < variant.passes; i++)
+		cv::erode(threshold, threshold, erodeElement);
+	for (int i = 0; i < variant.passes; i++)
+		cv::dilate(threshold, threshold, dilateElement);
+}
+
+TargetStatus findTargetGeneric(const DetectorVariant &variant, const cv::Mat &threshold, double scale, Target &target) {
+	ContourBuffers &buffers = contourBuffers();
+	threshold.copyTo(buffers.temp);
+	findContours(buffers.temp, buffers.contours, buffers.hierarchy, variant.retrieval, cv::CHAIN_APPROX_SIMPLE);
+
+	if (variant.strips == 2)
+		return selectStripPair(buffers.contours, buffers.hierarchy, scale, variant.limits, target);
+	return selectTarget(buffers.contours, buffers.hierarchy, scale, variant.limits, target);
+}
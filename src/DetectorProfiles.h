@@ -0,0 +1,74 @@
+/*
+ * DetectorProfiles.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#ifndef DETECTORPROFILES_H_
+#define DETECTORPROFILES_H_
+
+#include <string>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include "TargetDetector.h"
+#include "ThresholdPipeline.h"
+
+// Compile time detector settings of each goal, named after the Goal types. Kernels are
+// MORPH_RECT anchored in the middle like morphOps and, like areas, are in camera pixels.
+// The high goal is the generic path, morphOps and findTarget with targetLimits.
+struct HighGoalProfile {
+	static constexpr int erode_size = ERODE_SIZE;
+	static constexpr int dilate_size = DILATE_SIZE;
+	static constexpr int retrieval = cv::RETR_CCOMP;
+	static constexpr int strips = 1;
+	static constexpr int max_objects = MAX_NUM_OBJECTS;
+	static constexpr double min_area = MIN_OBJECT_AREA;
+	static constexpr double max_area = MAX_OBJECT_AREA;
+};
+
+// The peg tape is two thin vertical strips, a smaller dilate keeps them apart. The target is the
+// midpoint of the pair, the peg sits between them.
+struct GearPegProfile {
+	static constexpr int erode_size = ERODE_SIZE;
+	static constexpr int dilate_size = 5;
+	static constexpr int retrieval = cv::RETR_EXTERNAL;
+	static constexpr int strips = 2;
+	static constexpr int max_objects = 20;
+	static constexpr double min_area = 16;
+	static constexpr double max_area = 720 * 404 / 8.0;	// An eighth of a 720x404 image.
+};
+
+// cvtColor, inRange and morphology of a frame into hsv and threshold.
+typedef void (*ThresholdFunction)(const cv::Mat &frame, cv::Scalar lower, cv::Scalar upper, cv::Mat &hsv, cv::Mat &threshold);
+// Contour search on a threshold image, like findTarget.
+typedef TargetStatus (*FindFunction)(const cv::Mat &threshold, double scale, Target &target);
+
+// One entry of the dispatch table, a profile fully specialised for one morphology pass count
+// and processing scale.
+struct DetectorVariant {
+	const char *profile;
+	int passes;
+	int scale_percent;
+	ThresholdFunction threshold;
+	FindFunction find;
+
+	// The same settings at run time, for the generic path. Kernel sizes are scaled to processing pixels.
+	int erode_size;
+	int dilate_size;
+	int retrieval;
+	int strips;		// 1 for selectTarget, 2 for selectStripPair.
+	TargetLimits limits;
+};
+
+// The variant of profile for a pass count and processing scale, NULL if there is none.
+const DetectorVariant *findDetectorVariant(const std::string &profile, int passes, double scale);
+
+// The whole dispatch table.
+const DetectorVariant *getDetectorVariants(int &count);
+
+// The generic path with the settings of a variant: run time kernels, retrieval mode and limits.
+void thresholdGeneric(const DetectorVariant &variant, const cv::Mat &frame, cv::Scalar lower, cv::Scalar upper, cv::Mat &hsv, cv::Mat &threshold);
+TargetStatus findTargetGeneric(const DetectorVariant &variant, const cv::Mat &threshold, double scale, Target &target);
+
+#endif /* DETECTORPROFILES_H_ */
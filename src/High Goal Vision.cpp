@@ -9,7 +9,20 @@
 #include <iostream>
 #include "High Goal Vision.h"
 #include "NetworkTablesClient.h"
+#include "QualityGovernor.h"
+#include "MjpegServer.h"
+#include "MaskCodec.h"
+#include "TargetDetector.h"
+#include "TargetGeometry.h"
+#include "ThresholdPipeline.h"
+#include "Config.h"
+#include "RealTime.h"
+#include "StreamEncoder.h"
+#include "Benchmark.h"
+#include "HsvTuner.h"
+#include "DetectorProfiles.h"
 #include <ctime>
+#include <chrono>
 
 //initial min and max HSV filter values.
 int H_MIN = 0;
@@ -32,12 +45,14 @@ int WHITEBALANCE = -1;
 int imageWidth = 720;
 int imageHeight = 404;
 
-//max number of objects to be detected in frame
-const int MAX_NUM_OBJECTS = 50;
+// MAX_NUM_OBJECTS, MIN_OBJECT_AREA and MAX_OBJECT_AREA are in TargetDetector.h, shared with
+// the detector profiles.
+const TargetLimits targetLimits = {MAX_NUM_OBJECTS, MIN_OBJECT_AREA, MAX_OBJECT_AREA};
 
-//minimum and maximum object area
-const int MIN_OBJECT_AREA = 1 * 1;
-const int MAX_OBJECT_AREA = imageWidth*imageHeight / 1.5;
+// Camera mount pose on the robot, x, y, z in meters then yaw, pitch, roll in degrees.
+// Target positions in the robot frame are only published when useCameraMount is set.
+bool useCameraMount = false;
+double cameraMountPose[6] = {0, 0, 0, 0, 0, 0};
 
 bool calibrationMode = false; //used for showing debugging windows, trackbars etc.
 bool HSVFromSD = false; // Used to coordinate HSV value push from the SmartDashboard after core startup.
@@ -51,7 +66,76 @@ std::vector<int> H_ROI, S_ROI, V_ROI;// HSV values from the click/drag ROI regio
 // How many frames per second for the output image to the smartdashboard.
 int sdFPS = 15;
 
+// Size of the smartdashboard streams.
+const cv::Size sdStreamSize(320, 180);
+
+// Port of the MJPEG server for the smartdashboard streams, 5800-5810 are open on the field.
+int streamPort = 5800;
+
+// Only recompute the tiles of the threshold image that changed since the last frame, pays off
+// while the robot is standing still lining up a shot.
+bool incrementalMode = false;
+int incrementalTileSize = 32;
+int incrementalChangeThreshold = 20;	// Per pixel colour difference, see IncrementalThreshold.
+int incrementalChangePixels = 2;
+int incrementalRefreshFrames = 30;		// Recompute the whole frame this often.
+
+// Split cvtColor, inRange and morphOps into stripes run on OpenCV's thread pool, the threshold
+// image is bit identical to the serial path. threadCount sets the pool size, 0 leaves OpenCV's default.
+// Real time mode turns the pool off, see setupRealTime.
+bool parallelThreshold = true;
+int threadCount = 0;
+
+// Find the target from labelBlobs instead of findContours. Also parallel, but blob areas are
+// pixel counts rather than contour areas so the chosen target can differ slightly.
+bool parallelLabelling = false;
+
+// Goal profile whose compile time specialised detector replaces the threshold pipeline and
+// contour search, empty for the generic path. incrementalMode and parallelThreshold only apply
+// to the generic path.
+std::string detectorProfile = "";
+
+// NetworkTables keys of the published target, named after the goal so the robot never reads a
+// gear peg as the high goal. Set by applyConfig from the profile.
+std::string anglesKey = "High Goal Angles";
+std::string posKey = "High Goal Pos";
+std::string cameraXYZKey = "High Goal Camera XYZ";
+std::string robotXYZKey = "High Goal Robot XYZ";
+
+// Per frame processing budget in milliseconds, the quality governor steps down to stay inside it.
+double frameBudgetMs = 1000.0 / 30;
+
+// Core the capture/detect loop runs on.
+int detectCore = 2;
+
+// Real time mode: the loop runs with SCHED_FIFO on detectCore, memory is locked and every other
+// thread is moved to auxCores (all other cores if empty).
+bool realTimeMode = false;
+int detectPriority = 80;
+bool lockMemoryRT = true;
+std::vector<int> auxCores;
+
+// Loop period above which a frame counts as late, and how often the jitter histograms are reported.
+double periodDeadlineMs = 25;
+int jitterReportFrames = 600;
+
 NetworkTablesClient ntc;
+TargetGeometry targetGeometry;
+
+// Encode cost and size of the threshold mask codecs, compared in calibration mode.
+typedef struct codecStatsStruct {
+	double encode_ms;
+	double bytes;
+	int frames;
+	std::chrono::steady_clock::time_point first_send;	// Start of the measured send interval.
+} codecStats;
+
+codecStats rleStats = {0, 0, 0, std::chrono::steady_clock::time_point()};
+codecStats jpegStats = {0, 0, 0, std::chrono::steady_clock::time_point()};
+
+// Run length coded threshold mask for the smartdashboard, a key frame about once a second.
+// Only used on the stream encoder thread, see publishThreshRle.
+MaskEncoder threshEncoder(sdStreamSize.width, sdStreamSize.height, sdFPS);
 
 typedef struct mouseOCVStruct {
 	sl::Mat depth;
@@ -66,19 +150,70 @@ int main(int argc, char **argv) {
 	bool trackObjects = true;
 	bool useMorphOps = true;
 
-	// Determine number of clock cycles between output frames.
-	std::clock_t clocks_per_frame = CLOCKS_PER_SEC / sdFPS;
-	std::clock_t last_clock = 0;
+	// Settings from --config=<file> and --key=value options, any other argument turns on calibration mode.
+	Config config;
+	config.parseArgs(argc, argv);
+	applyConfig(config);
+
+	// --bench_threshold only times the threshold paths on synthetic frames, no camera needed.
+	if (config.getBool("bench_threshold", false))
+		return runThresholdBenchmark() ? 0 : 1;
+	if (config.getBool("bench_profiles", false))
+		return runProfileBenchmark() ? 0 : 1;
 
-	// Turn on calibration mode if any argument is given.
-	if (argc > 1) {
+	if (calibrationMode)
 		std::cout << "Calibration Mode On" << std::endl;
-		calibrationMode = true;
+
+	// Time of the last frame sent to the smartdashboard, wall time since std::clock() counts the
+	// CPU time of every thread in the process.
+	std::chrono::steady_clock::time_point last_sd_send;
+
+	// Quality governor, keeps the processing time of each frame inside frameBudgetMs.
+	QualityGovernor governor(frameBudgetMs);
+
+	// --tune=<frame list> searches the HSV bounds on labelled frames with the detector at full
+	// quality, writes them to tune_output and exits, no camera needed. Hue is a single
+	// h_min..h_max range, a target whose hue wraps around 0 (red) is rejected.
+	if (config.has("tune")) {
+		HsvTuner tuner(targetLimits, governor.getLevel().processingScale, governor.getLevel().morphPasses);
+		if (!tuner.load(config.getString("tune", "")))
+			return 1;
+		HsvBounds bounds;
+		TuneScore score;
+		if (!tuner.tune(bounds, score))
+			return 1;
+		return HsvTuner::write(config.getString("tune_output", "hsv.conf"), bounds, score) ? 0 : 1;
 	}
 
+	ntc.putData("Quality Level", llvm::ArrayRef<double> {(double) governor.getLevelIndex()});
+	unsigned long frame_count = 0;
+
+	// Tile state of the threshold image for incrementalMode.
+	IncrementalThreshold incremental(incrementalTileSize, incrementalChangeThreshold, incrementalChangePixels, incrementalRefreshFrames);
+	ParallelThreshold parallel;
+
+	// Dashboard streams, JPEG encoded on their own thread. The threshold mask also goes to
+	// NetworkTables run length coded, encoded on the same thread.
+	MjpegServer mjpeg(streamPort);
+	StreamEncoder streamEncoder(&mjpeg, encode_for_sd, sdStreamSize);
+	streamEncoder.addStream("hg_image", CV_8UC4);
+	streamEncoder.addStream("hg_thresh", CV_8UC1);
+	streamEncoder.addMaskStream("hg_thresh_rle", publishThreshRle);
+	threshEncoder.setKeyframeInterval(sdFPS);
+
+	// Loop period and per frame processing time.
+	JitterHistogram loopPeriod(0.25, 200, periodDeadlineMs);
+	JitterHistogram frameLatency(0.25, 200, frameBudgetMs);
+	// Publishes the results and jitter reports on its own thread, off the detect core.
+	LoopReporter loopReporter(publishFrame, reportJitter, loopPeriod, frameLatency);
+	std::chrono::steady_clock::time_point last_frame_start;
+
 	// Create a ZED camera object
 	sl::Camera zed;
 
+	//matrix storage for the image at the processing resolution of the current quality level
+	cv::Mat image_proc;
+
 	//matrix storage for HSV image
 	cv::Mat HSV;
 
@@ -108,6 +243,13 @@ int main(int argc, char **argv) {
 	zed.setCameraSettings(sl::CAMERA_SETTINGS_EXPOSURE, EXPOSURE, true);
 	zed.setCameraSettings(sl::CAMERA_SETTINGS_WHITEBALANCE, WHITEBALANCE, true);
 
+	// Target angles use the calibration of the rectified left image, only the target centroid gets undistorted.
+	sl::CameraParameters left_cam = zed.getCameraInformation().calibration_parameters.left_cam;
+	targetGeometry.setCalibration(left_cam.fx, left_cam.fy, left_cam.cx, left_cam.cy, left_cam.disto);
+	if (useCameraMount)
+		targetGeometry.setMountPose(cameraMountPose[0], cameraMountPose[1], cameraMountPose[2],
+				cameraMountPose[3], cameraMountPose[4], cameraMountPose[5]);
+
 	// Set runtime parameters after opening the camera
 	sl::RuntimeParameters runtime_parameters;
 	runtime_parameters.sensing_mode = sl::SENSING_MODE_STANDARD; // Use STANDARD sensing mode
@@ -150,8 +292,25 @@ int main(int argc, char **argv) {
 		rectangleSelected = false;
 	}
 
-	// Jetson only. Execute the calling thread on 2nd core
-	sl::Camera::sticktoCPUCore(2);
+	// Serve the image and threshold streams, the dashboard finds the port in NetworkTables.
+	mjpeg.addStream("hg_image");
+	mjpeg.addStream("hg_thresh");
+	if (mjpeg.start())
+		ntc.putData("hg_stream_port", llvm::ArrayRef<double> {(double) mjpeg.getPort()});
+	streamEncoder.start();
+	loopReporter.start();
+
+	if (realTimeMode) {
+		setupRealTime();
+	}
+	else {
+		// Threads inherit the affinity of the thread that starts them, the pool workers must exist
+		// before this thread gets pinned to the detect core.
+		startThreadPool();
+
+		// Jetson only. Execute the calling thread on the detect core
+		sl::Camera::sticktoCPUCore(detectCore);
+	}
 
 	// Loop until 'q' is pressed
 	char key = ' ';
@@ -163,35 +322,119 @@ int main(int argc, char **argv) {
 
 		// Grab and display image and depth
 		if (zed.grab(runtime_parameters) == sl::SUCCESS) {
+			std::chrono::steady_clock::time_point frame_start = std::chrono::steady_clock::now();
+			const QualityLevel &quality = governor.getLevel();
+
+			if (frame_count > 0)
+				loopPeriod.add(std::chrono::duration<double, std::milli>(frame_start - last_frame_start).count());
+			last_frame_start = frame_start;
 
 			zed.retrieveImage(image_zed, sl::VIEW_LEFT); // Retrieve the left image
-			zed.retrieveImage(depth_image_zed, sl::VIEW_DEPTH); //Retrieve the depth view (image)
-			zed.retrieveMeasure(mouseStruct.depth, sl::MEASURE_DEPTH); // Retrieve the depth measure (32bits)
+			// The depth view is only used for display.
+			if (calibrationMode)
+				zed.retrieveImage(depth_image_zed, sl::VIEW_DEPTH); //Retrieve the depth view (image)
+			// Lower quality levels reuse the depth measure for a few frames.
+			if (frame_count % quality.depthInterval == 0)
+				zed.retrieveMeasure(mouseStruct.depth, sl::MEASURE_DEPTH); // Retrieve the depth measure (32bits)
+			frame_count++;
+
+			// Scale down to the processing resolution of the current quality level.
+			if (quality.processingScale < 1.0)
+				cv::resize(image_ocv, image_proc, cv::Size(), quality.processingScale, quality.processingScale, cv::INTER_NEAREST);
+			else
+				image_proc = image_ocv;
+
+			// Specialised detector of the profile for the pass count of this quality level.
+			const DetectorVariant *variant = NULL;
+			if (!detectorProfile.empty() && useMorphOps)
+				variant = findDetectorVariant(detectorProfile, quality.morphPasses, quality.processingScale);
+
+			bool thresholdChanged = true;
+			if (variant) {
+				variant->threshold(image_proc, cv::Scalar(H_MIN, S_MIN, V_MIN), cv::Scalar(H_MAX, S_MAX, V_MAX), HSV, threshold);
+
+				//set HSV values from user selected region
+				recordHSV_Values(image_ocv, HSV);
+			}
+			else if (incrementalMode) {
+				// Only recompute the tiles that changed since the last frame.
+				int passes = useMorphOps ? quality.morphPasses : 0;
+				thresholdChanged = incremental.process(image_proc, cv::Scalar(H_MIN, S_MIN, V_MIN), cv::Scalar(H_MAX, S_MAX, V_MAX), passes, quality.processingScale, threshold) > 0;
 
-			//convert frame from BGR to HSV colorspace
-			cvtColor(image_ocv, HSV, cv::COLOR_BGR2HSV);
+				//set HSV values from user selected region, used from the next frame on
+				recordHSV_Values(image_ocv, incremental.getHSV());
+			}
+			else if (parallelThreshold) {
+				// Same as below, one stripe of the frame per work item.
+				int passes = useMorphOps ? quality.morphPasses : 0;
+				parallel.process(image_proc, cv::Scalar(H_MIN, S_MIN, V_MIN), cv::Scalar(H_MAX, S_MAX, V_MAX), passes, quality.processingScale, threshold);
 
-			//set HSV values from user selected region
-			recordHSV_Values(image_ocv, HSV);
+				//set HSV values from user selected region
+				recordHSV_Values(image_ocv, parallel.getHSV());
+			}
+			else {
+				//convert frame from BGR to HSV colorspace
+				cvtColor(image_proc, HSV, cv::COLOR_BGR2HSV);
 
-			//filter HSV image between values and store filtered image to
-			//threshold matrix
-			inRange(HSV, cv::Scalar(H_MIN, S_MIN, V_MIN), cv::Scalar(H_MAX, S_MAX, V_MAX), threshold);
+				//set HSV values from user selected region
+				recordHSV_Values(image_ocv, HSV);
 
-			//perform morphological operations on thresholded image to eliminate noise
-			//and emphasize the filtered object(s)
-			if (useMorphOps)
-				morphOps(threshold);
+				//filter HSV image between values and store filtered image to
+				//threshold matrix
+				inRange(HSV, cv::Scalar(H_MIN, S_MIN, V_MIN), cv::Scalar(H_MAX, S_MAX, V_MAX), threshold);
+
+				//perform morphological operations on thresholded image to eliminate noise
+				//and emphasize the filtered object(s)
+				if (useMorphOps)
+					morphOps(threshold, quality.morphPasses, quality.processingScale);
+			}
 
 			//pass in thresholded frame to our object tracking function
 			//this function will return the x and y coordinates of the
 			//filtered object
+			FrameReport report;
+			report.status = TARGET_NONE;
 			if (trackObjects)
-				trackFilteredObject(x, y, threshold, image_ocv, mouseStruct.depth);
+				trackFilteredObject(x, y, threshold, image_ocv, mouseStruct.depth, quality, thresholdChanged, variant, report);
+
+			// Prep and stream the image for display on the smartdashboard, only encode what is being watched.
+			if (quality.sdFrameDivisor > 0 && frame_start - last_sd_send >
+					std::chrono::duration<double>((double) quality.sdFrameDivisor / sdFPS)) {
+				if (mjpeg.hasClients("hg_image"))
+					streamEncoder.put("hg_image", image_ocv);
+				if (mjpeg.hasClients("hg_thresh"))
+					streamEncoder.put("hg_thresh", threshold);
+
+				// The binary mask is small enough to go over NetworkTables, see publishThreshRle.
+				streamEncoder.put("hg_thresh_rle", threshold);
+				last_sd_send = frame_start;
+			}
+
+			// Step the quality level, the display windows below are not part of the budget.
+			double frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count();
+			frameLatency.add(frame_ms);
+			if (loopPeriod.getCount() >= jitterReportFrames) {
+				// Printing and publishing happen on the reporter thread, off the detect core.
+				loopReporter.putJitter(loopPeriod, frameLatency);
+				loopPeriod.reset();
+				frameLatency.reset();
+			}
+
+			// The first frame allocated the loop's buffers, the threshold images and this thread's
+			// contour and morphRegion buffers (the stream slots come from addStream), lock and
+			// fault them in now. Buffers reallocated on a quality level change reuse heap pages
+			// that stay locked.
+			if (realTimeMode && lockMemoryRT && frame_count == 1)
+				lockMemory(512 * 1024);
+
+			// Targets and level changes are published by the reporter thread.
+			report.quality_changed = governor.update(frame_ms);
+			report.quality_level = governor.getLevelIndex();
+			report.frame_ms = frame_ms;
+			loopReporter.putFrame(report);
 
 			// If not in calibration mode, don't display image windows.
 			if (calibrationMode) {
-				// Resize and display with OpenCV
 				// Resize and display with OpenCV
 				cv::resize(image_ocv, image_ocv_display, displaySize);
 				cv::resize(depth_image_ocv, depth_image_ocv_display, displaySize);
@@ -202,16 +445,12 @@ int main(int argc, char **argv) {
 
 				key = cv::waitKey(10);
 			}
-
-			// Prep and display the image for display on the smartdashboard.
-			if (clocks_per_frame < (std::clock() - last_clock)) {
-				ntc.putRaw("hg_image", encode_for_sd(image_ocv));
-				ntc.putRaw("hg_thresh", encode_for_sd(threshold));
-				last_clock = std::clock();
-			}
 		}
 	}
 
+	streamEncoder.stop();
+	loopReporter.stop();
+	mjpeg.stop();
 	zed.close();
 	return 0;
 }
@@ -279,12 +518,18 @@ void recordHSV_Values(cv::Mat frame, cv::Mat hsv_frame){
 		if (H_ROI.size()>0) H_ROI.clear();
 		if (S_ROI.size()>0) S_ROI.clear();
 		if (V_ROI.size()>0 )V_ROI.clear();
+		//the HSV frame may be at a lower processing resolution than the camera frame
+		double scale = (double) hsv_frame.cols / frame.cols;
+		cv::Rect hsvROI(cv::Point(rectangleROI.tl().x * scale, rectangleROI.tl().y * scale),
+				cv::Point(rectangleROI.br().x * scale, rectangleROI.br().y * scale));
+		hsvROI &= cv::Rect(0, 0, hsv_frame.cols, hsv_frame.rows);
+
 		//if the rectangle has no width or height (user has only dragged a line) then we don't try to iterate over the width or height
-		if (rectangleROI.width<1 || rectangleROI.height<1) std::cout << "Please drag a rectangle, not a line" << std::endl;
+		if (hsvROI.width<1 || hsvROI.height<1) std::cout << "Please drag a rectangle, not a line" << std::endl;
 		else{
-			for (int i = rectangleROI.x; i<rectangleROI.x + rectangleROI.width; i++){
+			for (int i = hsvROI.x; i<hsvROI.x + hsvROI.width; i++){
 				//iterate through both x and y direction and save HSV values at each and every point
-				for (int j = rectangleROI.y; j<rectangleROI.y + rectangleROI.height; j++){
+				for (int j = hsvROI.y; j<hsvROI.y + hsvROI.height; j++){
 					//save HSV value at this point
 					H_ROI.push_back((int)hsv_frame.at<cv::Vec3b>(j, i)[0]);
 					S_ROI.push_back((int)hsv_frame.at<cv::Vec3b>(j, i)[1]);
@@ -368,85 +613,70 @@ void drawObject(int x, int y, cv::Mat &frame){
 	cv::putText(frame, std::to_string(x) + "," + std::to_string(y), cv::Point(x, y + 30), 1, 1, cv::Scalar(0, 255, 0), 2);
 
 }
-void morphOps(cv::Mat &thresh){
-
-	//create structuring element that will be used to "dilate" and "erode" image.
-	//the element chosen here is a 3px by 3px rectangle
-
-	cv::Mat erodeElement = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
-	//dilate with larger element so make sure object is nicely visible
-	cv::Mat dilateElement = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(8, 8));
-
-	cv::erode(thresh, thresh, erodeElement);
-	cv::erode(thresh, thresh, erodeElement);
-
-
-	cv::dilate(thresh, thresh, dilateElement);
-	cv::dilate(thresh, thresh, dilateElement);
+void trackFilteredObject(int &x, int &y, cv::Mat threshold, cv::Mat &cameraFeed, sl::Mat &depth, const QualityLevel &quality, bool thresholdChanged, const DetectorVariant *variant, FrameReport &report) {
+	// The contour search result of the last frame still holds if the threshold image is unchanged.
+	static Target target;
+	static TargetStatus status = TARGET_NONE;
+
+	//the threshold image may be at a lower processing resolution than the camera feed
+	if (thresholdChanged) {
+		if (variant)
+			status = variant->find(threshold, quality.processingScale, target);
+		else if (parallelLabelling)
+			status = findTargetBlobs(threshold, quality.processingScale, targetLimits, target);
+		else
+			status = findTarget(threshold, quality.processingScale, targetLimits, target);
+	}
 
+	//let user know you found an object
+	if (status == TARGET_FOUND) {
+		x = cvRound(target.centroid.x);
+		y = cvRound(target.centroid.y);
 
+		if (quality.drawOverlays) {
+			putText(cameraFeed, "Tracking Object", cv::Point(0, 50), 2, 1, cv::Scalar(0, 255, 0), 2);
+			//draw object location on screen
+			drawObject(x, y, cameraFeed);
+		}
 
+		// Angles and positions are worked out and published by publishFrame.
+		sl::float1 dist;
+		depth.getValue(x, y, &dist);
+		report.target = target;
+		report.depth = dist;
+	}
+	else if (status == TARGET_NOISY && quality.drawOverlays) {
+		putText(cameraFeed, "TOO MUCH NOISE! ADJUST FILTER", cv::Point(0, 50), 1, 2, cv::Scalar(0, 0, 255), 2);
+	}
+	report.status = status;
 }
-void trackFilteredObject(int &x, int &y, cv::Mat threshold, cv::Mat &cameraFeed, sl::Mat &depth) {
-	cv::Mat temp;
-	threshold.copyTo(temp);
-	//these two vectors needed for output of findContours
-	std::vector<std::vector<cv::Point> > contours;
-	std::vector<cv::Vec4i> hierarchy;
-	//find contours of filtered image using openCV findContours function
-	findContours(temp, contours, hierarchy, CV_RETR_CCOMP, CV_CHAIN_APPROX_SIMPLE);
-	//use moments method to find our filtered object
-	double refArea = 0;
-	int largestIndex = 0;
-	bool objectFound = false;
-	if (hierarchy.size() > 0) {
-		int numObjects = hierarchy.size();
-		//if number of objects greater than MAX_NUM_OBJECTS we have a noisy filter
-		if (numObjects<MAX_NUM_OBJECTS){
-			for (int index = 0; index >= 0; index = hierarchy[index][0]) {
-
-				cv::Moments moment = moments((cv::Mat)contours[index]);
-				double area = moment.m00;
-
-				//if the area is less than 20 px by 20px then it is probably just noise
-				//if the area is the same as the 3/2 of the image size, probably just a bad filter
-				//we only want the object with the largest area so we save a reference area each
-				//iteration and compare it to the area in the next iteration.
-				if (area>MIN_OBJECT_AREA && area<MAX_OBJECT_AREA && area>refArea){
-					x = moment.m10 / area;
-					y = moment.m01 / area;
-					objectFound = true;
-					refArea = area;
-					//save index of largest contour to use with drawContours
-					largestIndex = index;
-				}
-				else {
-					//std::cout << "Found item, but did not match size range." <<std::endl;
-					objectFound = false;
-				}
-				//these will be changed using trackbars
 
-			}
+void publishFrame(const FrameReport &report) {
+	if (report.quality_changed) {
+		std::cout << "Quality level " << report.quality_level << " (" << QualityGovernor::getLevel(report.quality_level).name
+				<< "), last frame took " << report.frame_ms << "ms" << std::endl;
+		ntc.putData("Quality Level", llvm::ArrayRef<double> {(double) report.quality_level});
+	}
 
-			//let user know you found an object
-			if (objectFound == true){
-				putText(cameraFeed, "Tracking Object", cv::Point(0, 50), 2, 1, cv::Scalar(0, 255, 0), 2);
-				//draw object location on screen
-				drawObject(x, y, cameraFeed);
+	if (report.status != TARGET_FOUND)
+		return;
 
-				sl::float1 dist;
-				depth.getValue(x, y, &dist);
+	// Angles only need the calibration, undistort just the centroid.
+	cv::Point2d normalised = targetGeometry.normalise(report.target.centroid);
+	ntc.putData(llvm::StringRef(anglesKey), llvm::ArrayRef<double> {targetGeometry.yaw(normalised), targetGeometry.pitch(normalised)});
 
-				if (isValidMeasure(dist)) {
-					ntc.putData(llvm::StringRef("High Goal Pos"), llvm::ArrayRef<double> {x,y,dist});
-				}
+	if (isValidMeasure(report.depth)) {
+		double x = cvRound(report.target.centroid.x);
+		double y = cvRound(report.target.centroid.y);
+		ntc.putData(llvm::StringRef(posKey), llvm::ArrayRef<double> {x, y, report.depth});
 
-				//draw largest contour
-				//drawContours(cameraFeed, contours, largestIndex, Scalar(0, 255, 255), 2);
-			}
+		cv::Point3d camera = targetGeometry.cameraPosition(normalised, report.depth);
+		ntc.putData(llvm::StringRef(cameraXYZKey), llvm::ArrayRef<double> {camera.x, camera.y, camera.z});
 
+		if (targetGeometry.hasMountPose()) {
+			cv::Point3d robot = targetGeometry.robotPosition(camera);
+			ntc.putData(llvm::StringRef(robotXYZKey), llvm::ArrayRef<double> {robot.x, robot.y, robot.z});
 		}
-		else putText(cameraFeed, "TOO MUCH NOISE! ADJUST FILTER", cv::Point(0, 50), 1, 2, cv::Scalar(0, 0, 255), 2);
 	}
 }
 
@@ -528,23 +758,15 @@ std::string encode_for_sd(cv::Mat input_image) {
 	param[1] = 80;//default(95) 0-100
 
 	// Output image size
-	int sd_image_width = 320;
-	int sd_image_height = 180;
-	cv::Size sd_display_size(sd_image_width, sd_image_height);
+	cv::Size sd_display_size = sdStreamSize;
 
 	cv::Mat output_image;
 
 	buff.clear();
 	cv::resize(input_image, output_image, sd_display_size);
 	cv::imencode(".jpg", output_image, buff, param);
-	std::stringstream ss;
-	for(size_t i = 0; i < buff.size(); ++i)
-	{
-		ss << buff[i];
-	}
-	ss.seekg(0, std::ios::beg);
 
-	return(ss.str());
+	return(std::string(buff.begin(), buff.end()));
 }
 
 void updateZedCamSettings(sl::Camera *zed) {
@@ -649,3 +871,182 @@ void updateZedCamSettings(sl::Camera *zed) {
 		ntc.PutBoolean("CamSettingsFromSD", false);
 	}
 }
+
+void publishThreshRle(const cv::Mat &mask) {
+	// A dashboard sets hg_thresh_rle_keyframe when it starts listening, so it does not wait for
+	// the next key frame to decode. A new connection of our own gets one too.
+	static bool wasConnected = false;
+	bool connected = ntc.isConnected();
+	bool requested = ntc.GetBoolean("hg_thresh_rle_keyframe");
+	if (requested || (connected && !wasConnected))
+		threshEncoder.forceKeyframe();
+	if (requested)
+		ntc.PutBoolean("hg_thresh_rle_keyframe", false);
+	wasConnected = connected;
+
+	std::chrono::steady_clock::time_point encode_start = std::chrono::steady_clock::now();
+	std::string thresh_rle = threshEncoder.encode(mask);
+	if (calibrationMode)
+		addCodecStats(rleStats, encode_start, thresh_rle.size());
+	ntc.putRaw("hg_thresh_rle", thresh_rle);
+
+	// Encode the JPEG as well for comparison.
+	if (calibrationMode) {
+		encode_start = std::chrono::steady_clock::now();
+		addCodecStats(jpegStats, encode_start, encode_for_sd(mask).size());
+		if (rleStats.frames >= 50)
+			reportThreshCodecs();
+	}
+}
+
+void addCodecStats(codecStats &stats, std::chrono::steady_clock::time_point encode_start, size_t bytes) {
+	if (stats.frames == 0)
+		stats.first_send = encode_start;
+	stats.encode_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - encode_start).count();
+	stats.bytes += bytes;
+	stats.frames++;
+}
+
+void reportThreshCodecs() {
+	// Print average encode time, frame size and NetworkTables bandwidth of both threshold codecs.
+	// The send rate is measured over the frames since the last report, it follows the quality
+	// level and any frames that missed the budget.
+	codecStats *stats[] = {&rleStats, &jpegStats};
+	const char *names[] = {"RLE ", "JPEG"};
+
+	for (int i = 0; i < 2; i++) {
+		double bytes = stats[i]->bytes / stats[i]->frames;
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - stats[i]->first_send).count();
+		double sendFPS = seconds > 0 ? (stats[i]->frames - 1) / seconds : 0;
+		std::cout << "hg_thresh " << names[i] << ": " << stats[i]->encode_ms / stats[i]->frames << "ms encode, "
+				<< bytes << " bytes/frame, " << bytes * sendFPS * 8 / 1000 << " kbit/s at a measured " << sendFPS << " fps" << std::endl;
+		stats[i]->encode_ms = 0;
+		stats[i]->bytes = 0;
+		stats[i]->frames = 0;
+	}
+}
+
+// Config value of key if it lies in [min, max], otherwise value is kept and the setting reported.
+static int configInt(Config &config, const std::string &key, int value, int min, int max) {
+	int read = config.getInt(key, value);
+	if (read < min || read > max) {
+		std::cout << key << " = " << read << " is outside " << min << " to " << max << ", using " << value << std::endl;
+		return value;
+	}
+	return read;
+}
+
+static double configDouble(Config &config, const std::string &key, double value, double min, double max) {
+	double read = config.getDouble(key, value);
+	if (!(read >= min && read <= max)) {
+		std::cout << key << " = " << read << " is outside " << min << " to " << max << ", using " << value << std::endl;
+		return value;
+	}
+	return read;
+}
+
+void applyConfig(Config &config) {
+	int cores = cv::getNumberOfCPUs();
+
+	calibrationMode = config.getBool("calibrate", calibrationMode);
+	sdFPS = configInt(config, "sd_fps", sdFPS, 1, 60);
+	streamPort = configInt(config, "stream_port", streamPort, 1, 65535);
+	frameBudgetMs = configDouble(config, "frame_budget_ms", frameBudgetMs, 1, 1000);
+
+	// Startup HSV bounds, e.g. from the auto tuner. The SmartDashboard can still override them.
+	H_MIN = configInt(config, "h_min", H_MIN, 0, 179);
+	H_MAX = configInt(config, "h_max", H_MAX, 0, 179);
+	S_MIN = configInt(config, "s_min", S_MIN, 0, 255);
+	S_MAX = configInt(config, "s_max", S_MAX, 0, 255);
+	V_MIN = configInt(config, "v_min", V_MIN, 0, 255);
+	V_MAX = configInt(config, "v_max", V_MAX, 0, 255);
+
+	incrementalMode = config.getBool("incremental", incrementalMode);
+	incrementalTileSize = configInt(config, "incremental_tile_size", incrementalTileSize, 4, 1024);
+	incrementalChangeThreshold = configInt(config, "incremental_change_threshold", incrementalChangeThreshold, 0, 254);
+	incrementalChangePixels = configInt(config, "incremental_change_pixels", incrementalChangePixels, 1, incrementalTileSize * incrementalTileSize);
+	incrementalRefreshFrames = configInt(config, "incremental_refresh_frames", incrementalRefreshFrames, 1, 100000);
+
+	parallelThreshold = config.getBool("parallel_threshold", parallelThreshold);
+	parallelLabelling = config.getBool("parallel_labelling", parallelLabelling);
+	threadCount = configInt(config, "threads", threadCount, 0, 256);
+	if (threadCount > 0)
+		cv::setNumThreads(threadCount);
+
+	// profile = high_goal or gear_peg, like the Goal types.
+	detectorProfile = config.getString("profile", detectorProfile);
+	if (!detectorProfile.empty() && !findDetectorVariant(detectorProfile, 1, 1.0)) {
+		std::cout << "Unknown detector profile " << detectorProfile << ", using the generic detector" << std::endl;
+		detectorProfile = "";
+	}
+	std::string targetName = detectorProfile == "gear_peg" ? "Gear Peg" : "High Goal";
+	anglesKey = targetName + " Angles";
+	posKey = targetName + " Pos";
+	cameraXYZKey = targetName + " Camera XYZ";
+	robotXYZKey = targetName + " Robot XYZ";
+
+	// camera_mount = x, y, z, yaw, pitch, roll
+	std::vector<double> mount = config.getDoubles("camera_mount");
+	if (mount.size() == 6) {
+		useCameraMount = true;
+		std::copy(mount.begin(), mount.end(), cameraMountPose);
+	}
+	else if (!mount.empty()) {
+		std::cout << "camera_mount needs x, y, z, yaw, pitch, roll" << std::endl;
+	}
+
+	detectCore = configInt(config, "detect_core", detectCore, 0, cores - 1);
+	realTimeMode = config.getBool("rt", realTimeMode);
+	detectPriority = configInt(config, "rt_priority", detectPriority, 1, 99);
+	lockMemoryRT = config.getBool("rt_lock_memory", lockMemoryRT);
+	if (config.has("rt_aux_cores")) {
+		auxCores.clear();
+		std::vector<double> aux = config.getDoubles("rt_aux_cores");
+		for (size_t i = 0; i < aux.size(); i++) {
+			int core = (int) aux[i];
+			if (core >= 0 && core < cores && core != detectCore)
+				auxCores.push_back(core);
+			else
+				std::cout << "rt_aux_cores: ignoring core " << aux[i] << std::endl;
+		}
+	}
+
+	periodDeadlineMs = configDouble(config, "period_deadline_ms", periodDeadlineMs, 1, 1000);
+	jitterReportFrames = configInt(config, "jitter_report_frames", jitterReportFrames, 1, 1000000);
+}
+
+void setupRealTime() {
+	std::cout << "Real time mode, capture/detect loop on core " << detectCore << " with SCHED_FIFO priority " << detectPriority << std::endl;
+
+	// The FIFO loop would wait inside parallel_for_ on pool workers scheduled normally next to
+	// the other threads, so everything OpenCV does runs on the detect core instead.
+	if (parallelThreshold || parallelLabelling || cv::getNumThreads() > 1)
+		std::cout << "Real time mode turns off parallel_threshold, parallel_labelling and OpenCV's thread pool" << std::endl;
+	parallelThreshold = false;
+	parallelLabelling = false;
+	cv::setNumThreads(1);
+
+	// NetworkTables, the MJPEG server, the stream encoder and the ZED threads all go to the other cores.
+	std::vector<int> aux = auxCores.empty() ? otherCores(detectCore) : auxCores;
+	std::cout << "Moved " << isolateOtherThreads(aux) << " other threads off the detect core" << std::endl;
+
+	pinThread(pthread_self(), std::vector<int>(1, detectCore));
+	setFifoPriority(pthread_self(), detectPriority);
+
+	// The image buffers are allocated lazily by the first frame, the loop locks memory after it.
+	// Until then allocations must stay on the heap so they are covered.
+	if (lockMemoryRT)
+		keepHeapMemory();
+}
+
+void reportJitter(JitterHistogram &loopPeriod, JitterHistogram &frameLatency) {
+	// Loop Jitter: period p50, p99, max and late frames, then processing time p99, max and frames over budget.
+	ntc.putData("Loop Jitter", llvm::ArrayRef<double> {loopPeriod.percentile(0.5), loopPeriod.percentile(0.99),
+			loopPeriod.getMax(), (double) loopPeriod.getMisses(), frameLatency.percentile(0.99),
+			frameLatency.getMax(), (double) frameLatency.getMisses()});
+
+	if (realTimeMode || calibrationMode) {
+		loopPeriod.print("Loop period");
+		frameLatency.print("Frame processing");
+	}
+}
@@ -10,18 +10,29 @@
 
 #include <sstream>
 #include <string>
+#include <chrono>
 #include <opencv2/core.hpp>
+#include "QualityGovernor.h"
+#include "Config.h"
+#include "RealTime.h"
+#include "DetectorProfiles.h"
 
 static void onMouseCallback(int32_t event, int32_t x, int32_t y, int32_t flag, void * param);
 void clickAndDrag_Rectangle(int event, int x, int y, int flags, void* param);
 void recordHSV_Values(cv::Mat frame, cv::Mat hsv_frame);
 std::string intToString(int number);
 void drawObject(int x, int y, cv::Mat &frame);
-void morphOps(cv::Mat &thresh);
-void trackFilteredObject(int &x, int &y, cv::Mat threshold, cv::Mat &cameraFeed, sl::Mat &depth);
+void trackFilteredObject(int &x, int &y, cv::Mat threshold, cv::Mat &cameraFeed, sl::Mat &depth, const QualityLevel &quality, bool thresholdChanged, const DetectorVariant *variant, FrameReport &report);
+void publishFrame(const FrameReport &report);
 static void onMouseCallback(int32_t event, int32_t x, int32_t y, int32_t flag, void * param);
 void getHSV();
 std::string encode_for_sd(cv::Mat);
+void publishThreshRle(const cv::Mat &mask);
 void updateZedCamSettings(sl::Camera *);
+void addCodecStats(struct codecStatsStruct &stats, std::chrono::steady_clock::time_point encode_start, size_t bytes);
+void reportThreshCodecs();
+void applyConfig(Config &config);
+void setupRealTime();
+void reportJitter(JitterHistogram &loopPeriod, JitterHistogram &frameLatency);
 
 #endif /* HIGH_GOAL_VISION_H_ */
@@ -0,0 +1,435 @@
+/*
+ * HsvTuner.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#include "HsvTuner.h"
+#include "ThresholdPipeline.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+
+// Histogram bins of the coarse search, 8 bit hue only goes up to 179.
+static const int H_BIN = 6;
+static const int S_BIN = 8;
+static const int V_BIN = 8;
+static const int H_BINS = 180 / H_BIN;
+static const int S_BINS = 256 / S_BIN;
+static const int V_BINS = 256 / V_BIN;
+
+// Coarse ranges that get scored with the detector.
+static const int COARSE_CANDIDATES = 32;
+
+// Moves per step size of the refinement, so it always ends.
+static const int MAX_REFINE_MOVES = 20;
+
+// Relative pixel F1 gain that counts as a target hue wrapping around 0, see hueWraps.
+static const double WRAP_F1_GAIN = 1.02;
+
+static inline int sumIndex(int h, int s, int v) {
+	return (h * (S_BINS + 1) + s) * (V_BINS + 1) + v;
+}
+
+// Count of bins [h0, h1] x [s0, s1] x [v0, v1] from a summed histogram.
+static inline double boxSum(const double *sum, int h0, int h1, int s0, int s1, int v0, int v1) {
+	h1++; s1++; v1++;
+	return sum[sumIndex(h1, s1, v1)] - sum[sumIndex(h0, s1, v1)] - sum[sumIndex(h1, s0, v1)] - sum[sumIndex(h1, s1, v0)]
+			+ sum[sumIndex(h0, s0, v1)] + sum[sumIndex(h0, s1, v0)] + sum[sumIndex(h1, s0, v0)] - sum[sumIndex(h0, s0, v0)];
+}
+
+static bool better(const TuneScore &a, const TuneScore &b) {
+	if (std::fabs(a.f1 - b.f1) > 1e-9)
+		return a.f1 > b.f1;
+	return a.centroid_error < b.centroid_error;
+}
+
+static bool parseInts(const std::string &s, int *values, int count) {
+	std::istringstream in(s);
+	for (int i = 0; i < count; i++)
+		if (!(in >> values[i]))
+			return false;
+	std::string rest;
+	return !(in >> rest);
+}
+
+struct CoarseRange {
+	double f1;
+	int h0, h1, s0, s1, v0, v1;
+};
+
+static bool higherF1(const CoarseRange &a, const CoarseRange &b) {
+	return a.f1 > b.f1;
+}
+
+// The vision filter is one H_MIN..H_MAX range, so the search never wraps around hue 0. A target
+// that does, like red at 170..10, shows up as a best range against one end of the hue axis that
+// scores better with hues from the other end added. Only checks up to a quarter of the axis.
+static bool hueWraps(const std::vector<double> &inside, const std::vector<double> &outside, const CoarseRange &r) {
+	bool at_low = r.h0 == 0;
+	bool at_high = r.h1 == H_BINS - 1;
+	if (at_low == at_high)
+		return false;
+
+	const double *in = &inside[0];
+	const double *out = &outside[0];
+	double total_in = in[sumIndex(H_BINS, S_BINS, V_BINS)];
+	double tp = boxSum(in, r.h0, r.h1, r.s0, r.s1, r.v0, r.v1);
+	double fp = boxSum(out, r.h0, r.h1, r.s0, r.s1, r.v0, r.v1);
+	double f1 = 2 * tp / (tp + fp + total_in);
+
+	for (int k = 1; k <= H_BINS / 4; k++) {
+		int h0 = at_low ? H_BINS - k : 0;
+		int h1 = at_low ? H_BINS - 1 : k - 1;
+		if (at_low ? h0 <= r.h1 : h1 >= r.h0)
+			break;
+		double wrapped_tp = tp + boxSum(in, h0, h1, r.s0, r.s1, r.v0, r.v1);
+		double wrapped_fp = fp + boxSum(out, h0, h1, r.s0, r.s1, r.v0, r.v1);
+		if (2 * wrapped_tp / (wrapped_tp + wrapped_fp + total_in) > f1 * WRAP_F1_GAIN)
+			return true;
+	}
+	return false;
+}
+
+static HsvBounds toBounds(const CoarseRange &r) {
+	HsvBounds b = {{r.h0 * H_BIN, r.s0 * S_BIN, r.v0 * V_BIN},
+			{std::min(179, (r.h1 + 1) * H_BIN - 1), (r.s1 + 1) * S_BIN - 1, (r.v1 + 1) * V_BIN - 1}};
+	return b;
+}
+
+// Histogram of the pixels inside and outside the box of each frame, one frame per work item.
+class FrameHistograms : public cv::ParallelLoopBody {
+public:
+	FrameHistograms(const std::vector<cv::Mat> &hsv, const std::vector<cv::Rect> &boxes, std::vector<std::vector<int> > &counts)
+		: hsv(hsv), boxes(boxes), counts(counts) {}
+
+	void operator()(const cv::Range &range) const {
+		int bins = H_BINS * S_BINS * V_BINS;
+		for (int i = range.start; i < range.end; i++) {
+			// Inside counts first, then outside.
+			std::vector<int> &count = counts[i];
+			count.assign(2 * bins, 0);
+			for (int y = 0; y < hsv[i].rows; y++) {
+				const uchar *p = hsv[i].ptr<uchar>(y);
+				for (int x = 0; x < hsv[i].cols; x++, p += 3) {
+					int bin = (std::min(p[0] / H_BIN, H_BINS - 1) * S_BINS + p[1] / S_BIN) * V_BINS + p[2] / V_BIN;
+					count[boxes[i].contains(cv::Point(x, y)) ? bin : bins + bin]++;
+				}
+			}
+		}
+	}
+
+private:
+	const std::vector<cv::Mat> &hsv;
+	const std::vector<cv::Rect> &boxes;
+	std::vector<std::vector<int> > &counts;
+};
+
+// Every bin aligned range with the given lowest hue bin, keeping the best by pixel F1.
+class CoarseSearch : public cv::ParallelLoopBody {
+public:
+	CoarseSearch(const std::vector<double> &inside, const std::vector<double> &outside, std::vector<std::vector<CoarseRange> > &best)
+		: inside(inside), outside(outside), best(best) {}
+
+	void operator()(const cv::Range &range) const {
+		const double *in = &inside[0];
+		const double *out = &outside[0];
+		double total_in = in[sumIndex(H_BINS, S_BINS, V_BINS)];
+
+		for (int h0 = range.start; h0 < range.end; h0++) {
+			std::vector<CoarseRange> &top = best[h0];
+			top.clear();
+			for (int h1 = h0; h1 < H_BINS; h1++)
+			for (int s0 = 0; s0 < S_BINS; s0++)
+			for (int s1 = s0; s1 < S_BINS; s1++)
+			for (int v0 = 0; v0 < V_BINS; v0++)
+			for (int v1 = v0; v1 < V_BINS; v1++) {
+				double tp = boxSum(in, h0, h1, s0, s1, v0, v1);
+				if (tp <= 0)
+					continue;
+				double fp = boxSum(out, h0, h1, s0, s1, v0, v1);
+				CoarseRange r = {2 * tp / (tp + fp + total_in), h0, h1, s0, s1, v0, v1};
+				if ((int) top.size() == COARSE_CANDIDATES && r.f1 <= top.back().f1)
+					continue;
+
+				top.insert(std::upper_bound(top.begin(), top.end(), r, higherF1), r);
+				if ((int) top.size() > COARSE_CANDIDATES)
+					top.pop_back();
+			}
+		}
+	}
+
+private:
+	const std::vector<double> &inside;
+	const std::vector<double> &outside;
+	std::vector<std::vector<CoarseRange> > &best;
+};
+
+// Scores one set of bounds with the detector per work item.
+class EvaluateBounds : public cv::ParallelLoopBody {
+public:
+	EvaluateBounds(HsvTuner &tuner, const std::vector<HsvBounds> &bounds, std::vector<TuneScore> &scores)
+		: tuner(tuner), bounds(bounds), scores(scores) {}
+
+	void operator()(const cv::Range &range) const {
+		for (int i = range.start; i < range.end; i++)
+			scores[i] = tuner.evaluate(bounds[i]);
+	}
+
+private:
+	HsvTuner &tuner;
+	const std::vector<HsvBounds> &bounds;
+	std::vector<TuneScore> &scores;
+};
+
+HsvTuner::HsvTuner(const TargetLimits &limits, double scale, int passes) {
+	this->limits = limits;
+	this->scale = scale;
+	this->passes = passes;
+}
+
+HsvTuner::~HsvTuner() {
+}
+
+bool HsvTuner::load(const std::string &list_path) {
+	std::ifstream file(list_path.c_str());
+	if (!file) {
+		std::cout << "Cannot open frame list " << list_path << std::endl;
+		return false;
+	}
+
+	size_t slash = list_path.rfind('/');
+	std::string dir = slash == std::string::npos ? "" : list_path.substr(0, slash + 1);
+
+	std::string line;
+	int line_number = 0;
+	bool ok = true;
+	while (std::getline(file, line)) {
+		line_number++;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+			line.erase(comment);
+		size_t start = line.find_first_not_of(" \t\r\n");
+		if (start == std::string::npos)
+			continue;
+		line = line.substr(start, line.find_last_not_of(" \t\r\n") - start + 1);
+
+		// The box is the last four fields, so paths may contain spaces.
+		Frame frame;
+		frame.has_target = false;
+		std::string path = line;
+		size_t split = line.size();
+		for (int fields = 0; fields < 4 && split != std::string::npos; fields++) {
+			split = line.find_last_not_of(" \t", split - 1);
+			if (split != std::string::npos)
+				split = line.find_last_of(" \t", split);
+		}
+		int box[4];
+		if (split != std::string::npos && parseInts(line.substr(split), box, 4)) {
+			frame.has_target = true;
+			frame.box = cv::Rect(box[0], box[1], box[2], box[3]);
+			path = line.substr(0, line.find_last_not_of(" \t", split) + 1);
+		}
+		if (path[0] != '/')
+			path = dir + path;
+
+		cv::Mat image = cv::imread(path, cv::IMREAD_COLOR);
+		if (image.empty()) {
+			std::cout << list_path << ":" << line_number << ": cannot read " << path << std::endl;
+			ok = false;
+			continue;
+		}
+
+		// Same processing resolution as the vision loop.
+		if (scale < 1.0)
+			cv::resize(image, image, cv::Size(), scale, scale, cv::INTER_NEAREST);
+		cvtColor(image, frame.hsv, cv::COLOR_BGR2HSV);
+		frames.push_back(frame);
+	}
+
+	std::cout << "Loaded " << frames.size() << " labelled frames from " << list_path << std::endl;
+	return ok && !frames.empty();
+}
+
+void HsvTuner::buildHistograms() {
+	int n = frames.size();
+	std::vector<cv::Mat> hsv(n);
+	std::vector<cv::Rect> boxes(n);
+	for (int i = 0; i < n; i++) {
+		hsv[i] = frames[i].hsv;
+		if (frames[i].has_target) {
+			cv::Rect box = frames[i].box;
+			boxes[i] = cv::Rect(cvRound(box.x * scale), cvRound(box.y * scale), cvRound(box.width * scale), cvRound(box.height * scale));
+		}
+	}
+
+	std::vector<std::vector<int> > counts(n);
+	cv::parallel_for_(cv::Range(0, n), FrameHistograms(hsv, boxes, counts));
+
+	// Add up all frames, then sum along each axis in turn.
+	int bins = H_BINS * S_BINS * V_BINS;
+	int sum_size = (H_BINS + 1) * (S_BINS + 1) * (V_BINS + 1);
+	inside.assign(sum_size, 0);
+	outside.assign(sum_size, 0);
+	for (int i = 0; i < n; i++) {
+		for (int h = 0; h < H_BINS; h++)
+		for (int s = 0; s < S_BINS; s++)
+		for (int v = 0; v < V_BINS; v++) {
+			int bin = (h * S_BINS + s) * V_BINS + v;
+			inside[sumIndex(h + 1, s + 1, v + 1)] += counts[i][bin];
+			outside[sumIndex(h + 1, s + 1, v + 1)] += counts[i][bins + bin];
+		}
+	}
+
+	std::vector<double> *sums[] = {&inside, &outside};
+	for (int k = 0; k < 2; k++) {
+		std::vector<double> &sum = *sums[k];
+		for (int h = 1; h <= H_BINS; h++)
+		for (int s = 0; s <= S_BINS; s++)
+		for (int v = 0; v <= V_BINS; v++)
+			sum[sumIndex(h, s, v)] += sum[sumIndex(h - 1, s, v)];
+		for (int h = 0; h <= H_BINS; h++)
+		for (int s = 1; s <= S_BINS; s++)
+		for (int v = 0; v <= V_BINS; v++)
+			sum[sumIndex(h, s, v)] += sum[sumIndex(h, s - 1, v)];
+		for (int h = 0; h <= H_BINS; h++)
+		for (int s = 0; s <= S_BINS; s++)
+		for (int v = 1; v <= V_BINS; v++)
+			sum[sumIndex(h, s, v)] += sum[sumIndex(h, s, v - 1)];
+	}
+}
+
+TuneScore HsvTuner::evaluate(const HsvBounds &bounds) {
+	int targets = 0, detections = 0, hits = 0;
+	double error = 0;
+	cv::Mat threshold;
+
+	for (size_t i = 0; i < frames.size(); i++) {
+		const Frame &frame = frames[i];
+		if (frame.has_target)
+			targets++;
+
+		inRange(frame.hsv, cv::Scalar(bounds.min[0], bounds.min[1], bounds.min[2]), cv::Scalar(bounds.max[0], bounds.max[1], bounds.max[2]), threshold);
+		morphOps(threshold, passes, scale);
+
+		Target target;
+		if (findTarget(threshold, scale, limits, target) != TARGET_FOUND)
+			continue;
+
+		detections++;
+		cv::Rect2d box = frame.box;
+		if (frame.has_target && box.contains(target.centroid)) {
+			hits++;
+			cv::Point2d centre(box.x + box.width / 2, box.y + box.height / 2);
+			error += cv::norm(target.centroid - centre);
+		}
+	}
+
+	TuneScore score;
+	score.precision = detections ? (double) hits / detections : 0;
+	score.recall = targets ? (double) hits / targets : 1;
+	score.f1 = score.precision + score.recall > 0 ? 2 * score.precision * score.recall / (score.precision + score.recall) : 0;
+	score.centroid_error = hits ? error / hits : 0;
+	return score;
+}
+
+bool HsvTuner::tune(HsvBounds &current, TuneScore &best_score) {
+	std::cout << "Building HSV histograms" << std::endl;
+	buildHistograms();
+
+	// Coarse search, one work item per lowest hue bin.
+	std::vector<std::vector<CoarseRange> > best(H_BINS);
+	cv::parallel_for_(cv::Range(0, H_BINS), CoarseSearch(inside, outside, best));
+
+	std::vector<CoarseRange> coarse;
+	for (int h0 = 0; h0 < H_BINS; h0++)
+		coarse.insert(coarse.end(), best[h0].begin(), best[h0].end());
+	std::sort(coarse.begin(), coarse.end(), higherF1);
+	if ((int) coarse.size() > COARSE_CANDIDATES)
+		coarse.resize(COARSE_CANDIDATES);
+	if (coarse.empty()) {
+		std::cout << "No HSV range covers any labelled target" << std::endl;
+		return false;
+	}
+	if (hueWraps(inside, outside, coarse[0])) {
+		std::cout << "The target hue wraps around 0 (red), h_min..h_max cannot hold a split hue range."
+				<< " Retune the camera or pick a target colour away from red." << std::endl;
+		return false;
+	}
+
+	// Score the best coarse ranges with the detector.
+	std::vector<HsvBounds> candidates;
+	for (size_t i = 0; i < coarse.size(); i++)
+		candidates.push_back(toBounds(coarse[i]));
+	std::vector<TuneScore> scores(candidates.size());
+	cv::parallel_for_(cv::Range(0, candidates.size()), EvaluateBounds(*this, candidates, scores));
+
+	int pick = 0;
+	for (size_t i = 1; i < scores.size(); i++)
+		if (better(scores[i], scores[pick]))
+			pick = i;
+	current = candidates[pick];
+	best_score = scores[pick];
+	std::cout << "Coarse search: precision " << best_score.precision << ", recall " << best_score.recall
+			<< ", centroid error " << best_score.centroid_error << "px" << std::endl;
+
+	// Refine, moving one bound at a time by step, all twelve moves scored in parallel.
+	const int limit[3] = {179, 255, 255};
+	for (int step = 8; step >= 1; step /= 2) {
+		for (int move = 0; move < MAX_REFINE_MOVES; move++) {
+			std::vector<HsvBounds> neighbours;
+			for (int channel = 0; channel < 3; channel++) {
+				for (int dir = -1; dir <= 1; dir += 2) {
+					HsvBounds b = current;
+					b.min[channel] = std::max(0, std::min(b.min[channel] + dir * step, b.max[channel]));
+					neighbours.push_back(b);
+
+					b = current;
+					b.max[channel] = std::min(limit[channel], std::max(b.max[channel] + dir * step, b.min[channel]));
+					neighbours.push_back(b);
+				}
+			}
+
+			scores.resize(neighbours.size());
+			cv::parallel_for_(cv::Range(0, neighbours.size()), EvaluateBounds(*this, neighbours, scores));
+
+			int next = -1;
+			for (size_t i = 0; i < scores.size(); i++)
+				if (better(scores[i], next < 0 ? best_score : scores[next]))
+					next = i;
+			if (next < 0)
+				break;
+			current = neighbours[next];
+			best_score = scores[next];
+		}
+	}
+
+	std::cout << "Refined: precision " << best_score.precision << ", recall " << best_score.recall
+			<< ", centroid error " << best_score.centroid_error << "px" << std::endl;
+	return true;
+}
+
+bool HsvTuner::write(const std::string &path, const HsvBounds &bounds, const TuneScore &score) {
+	std::ofstream file(path.c_str());
+	if (!file) {
+		std::cout << "Cannot write " << path << std::endl;
+		return false;
+	}
+
+	file << "# HSV filter bounds from the auto tuner, load with --config=" << path << std::endl;
+	file << "# precision " << score.precision << ", recall " << score.recall
+			<< ", centroid error " << score.centroid_error << "px" << std::endl;
+	const char *channels[] = {"h", "s", "v"};
+	for (int c = 0; c < 3; c++) {
+		file << channels[c] << "_min = " << bounds.min[c] << std::endl;
+		file << channels[c] << "_max = " << bounds.max[c] << std::endl;
+	}
+
+	std::cout << "Wrote HSV bounds to " << path << std::endl;
+	return true;
+}
@@ -0,0 +1,83 @@
+/*
+ * HsvTuner.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#ifndef HSVTUNER_H_
+#define HSVTUNER_H_
+
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "TargetDetector.h"
+
+// HSV filter bounds, inclusive like inRange. Index 0 is H, 1 is S and 2 is V.
+struct HsvBounds {
+	int min[3];
+	int max[3];
+};
+
+// How well the detector does with one set of bounds over all labelled frames.
+struct TuneScore {
+	double precision;		// Detections that hit a labelled box.
+	double recall;			// Labelled boxes that were hit.
+	double f1;
+	double centroid_error;	// Mean distance from a hit to its box centre, in camera pixels.
+};
+
+// Searches H_MIN..V_MAX for the bounds the detector does best with on a set of labelled frames.
+//
+// Every frame is converted to HSV once. A coarse search then scores every bin aligned range of a
+// 3D HSV histogram against the labelled boxes, using summed histograms so a range costs eight
+// lookups instead of a pass over the pixels. The best coarse ranges are run through the
+// production threshold and detector (inRange, morphOps, findTarget) and refined one bound at a
+// time. Both stages are spread over all cores with parallel_for_.
+//
+// Hue is searched as one h_min..h_max range, like the vision filter uses it. A target whose hue
+// wraps around 0, red for example, cannot be expressed and is rejected rather than tuned badly.
+class HsvTuner {
+public:
+	HsvTuner(const TargetLimits &limits, double scale, int passes);
+	virtual ~HsvTuner();
+
+	// Read a frame list, one frame per line: the image path followed by the target box x, y,
+	// width and height in camera pixels, or only the path for a frame without a target. Paths are
+	// relative to the list. '#' starts a comment.
+	bool load(const std::string &list_path);
+
+	// Finds the best bounds and their score. Returns false if no range covers the targets or the
+	// target hue wraps around 0.
+	bool tune(HsvBounds &bounds, TuneScore &best_score);
+
+	// Score one set of bounds with the production detector.
+	TuneScore evaluate(const HsvBounds &bounds);
+
+	// Write bounds as h_min .. v_max config keys, for --config=<path>.
+	static bool write(const std::string &path, const HsvBounds &bounds, const TuneScore &score);
+
+	int getNumFrames() {return frames.size();}
+
+private:
+	struct Frame {
+		cv::Mat hsv;		// At the processing scale.
+		bool has_target;
+		cv::Rect box;		// In camera pixels.
+	};
+
+	void buildHistograms();
+
+	TargetLimits limits;
+	double scale;
+	int passes;
+
+	std::vector<Frame> frames;
+
+	// Summed 3D histograms of the pixels inside and outside the labelled boxes, entry
+	// (h, s, v) holds the count of all bins below it.
+	std::vector<double> inside;
+	std::vector<double> outside;
+};
+
+#endif /* HSVTUNER_H_ */
@@ -0,0 +1,153 @@
+/*
+ * MaskCodec.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#include "MaskCodec.h"
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+
+static const char magic[] = "HGM";
+static const uint8_t version = 2;
+static const uint8_t flag_delta = 0x01;
+static const size_t header_size = 17;
+
+static void putVarint(std::string &out, uint32_t value) {
+	while (value >= 0x80) {
+		out.push_back((char) ((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	out.push_back((char) value);
+}
+
+static bool getVarint(const std::string &in, size_t &pos, uint32_t &value) {
+	value = 0;
+	for (int shift = 0; shift < 32 && pos < in.size(); shift += 7) {
+		uint8_t byte = (uint8_t) in[pos++];
+		value |= (uint32_t) (byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static void putLE(std::string &out, uint32_t value, int bytes) {
+	for (int i = 0; i < bytes; i++)
+		out.push_back((char) ((value >> (8 * i)) & 0xff));
+}
+
+static uint32_t getLE(const std::string &in, size_t pos, int bytes) {
+	uint32_t value = 0;
+	for (int i = 0; i < bytes; i++)
+		value |= (uint32_t) (uint8_t) in[pos + i] << (8 * i);
+	return value;
+}
+
+// Append the alternating off/on runs of a continuous mask, any non zero pixel counts as on.
+static void putRuns(std::string &out, const cv::Mat &mask) {
+	const uchar *p = mask.ptr<uchar>(0);
+	const uchar *end = p + mask.total();
+	bool on = false;
+
+	while (p < end) {
+		const uchar *start = p;
+		if (on)
+			while (p < end && *p) p++;
+		else
+			while (p < end && !*p) p++;
+		putVarint(out, (uint32_t) (p - start));
+		on = !on;
+	}
+}
+
+MaskEncoder::MaskEncoder(int width, int height, int keyframe_interval) {
+	this->size = cv::Size(width, height);
+	this->keyframe_interval = keyframe_interval;
+	// First frame is always a key frame.
+	this->frames_since_key = keyframe_interval;
+}
+
+MaskEncoder::~MaskEncoder() {
+}
+
+std::string MaskEncoder::encode(const cv::Mat &mask) {
+	// Nearest neighbour keeps the mask binary, then make sure on pixels are 255 so the XOR below
+	// only marks real changes.
+	cv::resize(mask, scaled, size, 0, 0, cv::INTER_NEAREST);
+	cv::compare(scaled, 0, scaled, cv::CMP_NE);
+
+	bool is_key = frames_since_key >= keyframe_interval || key.empty();
+	seq++;
+	if (is_key)
+		key_seq = seq;
+
+	std::string out;
+	out.reserve(header_size + 256);
+	out.append(magic, 3);
+	out.push_back((char) version);
+	out.push_back((char) (is_key ? 0 : flag_delta));
+	putLE(out, seq, 4);
+	putLE(out, key_seq, 4);
+	putLE(out, size.width, 2);
+	putLE(out, size.height, 2);
+
+	if (is_key) {
+		putRuns(out, scaled);
+		scaled.copyTo(key);
+		frames_since_key = 1;
+	}
+	else {
+		cv::bitwise_xor(scaled, key, delta);
+		putRuns(out, delta);
+		frames_since_key++;
+	}
+
+	return out;
+}
+
+MaskDecoder::MaskDecoder() {
+}
+
+MaskDecoder::~MaskDecoder() {
+}
+
+bool MaskDecoder::decode(const std::string &data, cv::Mat &mask) {
+	if (data.size() < header_size || data.compare(0, 3, magic) != 0 || (uint8_t) data[3] != version)
+		return false;
+
+	bool is_delta = (uint8_t) data[4] & flag_delta;
+	uint32_t frame_key_seq = getLE(data, 9, 4);
+	int width = getLE(data, 13, 2);
+	int height = getLE(data, 15, 2);
+
+	if (is_delta && (!have_key || frame_key_seq != key_seq || key.cols != width || key.rows != height))
+		return false;
+
+	cv::Mat decoded(height, width, CV_8UC1);
+	uchar *p = decoded.ptr<uchar>(0);
+	uchar *end = p + decoded.total();
+	size_t pos = header_size;
+	bool on = false;
+
+	while (p < end) {
+		uint32_t run;
+		if (!getVarint(data, pos, run) || run > (uint32_t) (end - p))
+			return false;
+		std::fill(p, p + run, on ? 255 : 0);
+		p += run;
+		on = !on;
+	}
+
+	if (is_delta) {
+		cv::bitwise_xor(key, decoded, mask);
+	}
+	else {
+		decoded.copyTo(key);
+		decoded.copyTo(mask);
+		have_key = true;
+		key_seq = frame_key_seq;
+	}
+	return true;
+}
@@ -0,0 +1,71 @@
+/*
+ * MaskCodec.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#ifndef MASKCODEC_H_
+#define MASKCODEC_H_
+
+#include <string>
+#include <stdint.h>
+#include <opencv2/core.hpp>
+
+// Run length codec for the binary threshold mask sent to the smartdashboard as hg_thresh_rle.
+//
+// Frame layout, all multi byte fields little endian:
+//   0  "HGM"            magic
+//   3  uint8  version   2
+//   4  uint8  flags     bit 0 set for a delta frame
+//   5  uint32 seq       frame number
+//   9  uint32 key_seq   frame number of the key frame a delta applies to, seq for a key frame
+//   13 uint16 width
+//   15 uint16 height
+//   17 runs             unsigned LEB128 varints
+//
+// The mask is scanned row by row as one line of width * height pixels. Runs alternate between
+// off and on pixels and always start with an off run, which may be 0 long. A delta frame holds
+// the runs of (mask XOR key frame mask). NetworkTables only sends the latest value of an entry
+// per flush, so the dashboard regularly misses frames; a delta still decodes as long as its key
+// frame arrived. Only a missed key frame leaves the decoder waiting for the next one.
+class MaskEncoder {
+public:
+	MaskEncoder(int width, int height, int keyframe_interval);
+	virtual ~MaskEncoder();
+
+	// Downscale the mask to the stream size and encode it.
+	std::string encode(const cv::Mat &mask);
+
+	// Send the next frame as a key frame, e.g. when a new dashboard connects.
+	void forceKeyframe() {frames_since_key = keyframe_interval;}
+
+	void setKeyframeInterval(int frames) {keyframe_interval = frames;}
+
+private:
+	cv::Size size;
+	int keyframe_interval;
+	int frames_since_key;
+	uint32_t seq = 0;
+	cv::Mat scaled;
+	uint32_t key_seq = 0;
+	cv::Mat key;
+	cv::Mat delta;
+};
+
+class MaskDecoder {
+public:
+	MaskDecoder();
+	virtual ~MaskDecoder();
+
+	// Decode a frame into mask (CV_8UC1, 0 or 255). Returns false for a corrupt frame or a delta
+	// whose key frame was not seen, mask then keeps the last good frame.
+	bool decode(const std::string &data, cv::Mat &mask);
+
+private:
+	bool have_key = false;
+	uint32_t key_seq = 0;
+	cv::Mat key;
+};
+
+#endif /* MASKCODEC_H_ */
@@ -0,0 +1,412 @@
+/*
+ * MjpegServer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#include "MjpegServer.h"
+#include <iostream>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+// Multipart boundary, also sent in front of every frame.
+static const char boundary[] = "hgframe";
+// Ends every frame part.
+static const char frame_trailer[] = "\r\n";
+// Requests longer than this are not from a browser or curl, drop them.
+static const size_t max_request_size = 4096;
+
+MjpegServer::MjpegServer(int port) {
+	this->port = port;
+	running = false;
+}
+
+MjpegServer::~MjpegServer() {
+	stop();
+}
+
+void MjpegServer::addStream(std::string name) {
+	std::unique_ptr<Stream> stream(new Stream());
+	stream->name = name;
+	stream->clients = 0;
+	streams.push_back(std::move(stream));
+}
+
+bool MjpegServer::start() {
+	if (running)
+		return true;
+
+	listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (listen_fd < 0) {
+		std::cout << "MJPEG server: socket failed: " << std::strerror(errno) << std::endl;
+		return false;
+	}
+
+	int reuse = 1;
+	setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	sockaddr_in addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+
+	if (bind(listen_fd, (sockaddr *) &addr, sizeof(addr)) < 0 || listen(listen_fd, 16) < 0) {
+		std::cout << "MJPEG server: cannot listen on port " << port << ": " << std::strerror(errno) << std::endl;
+		close(listen_fd);
+		listen_fd = -1;
+		return false;
+	}
+
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd < 0) {
+		perror("MJPEG server: epoll_create1");
+		close(listen_fd);
+		listen_fd = -1;
+		return false;
+	}
+
+	wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wake_fd < 0) {
+		perror("MJPEG server: eventfd");
+		close(epoll_fd);
+		close(listen_fd);
+		epoll_fd = listen_fd = -1;
+		return false;
+	}
+
+	epoll_event ev;
+	std::memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = listen_fd;
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev);
+	ev.data.fd = wake_fd;
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+
+	running = true;
+	thread = std::thread(&MjpegServer::run, this);
+
+	std::cout << "MJPEG server listening on port " << port << std::endl;
+	return true;
+}
+
+void MjpegServer::stop() {
+	if (!running)
+		return;
+
+	running = false;
+	uint64_t one = 1;
+	if (write(wake_fd, &one, sizeof(one)) < 0) {
+		// The thread still sees running == false on its next epoll timeout.
+	}
+	thread.join();
+
+	while (!clients.empty())
+		closeClient(clients.begin()->first);
+
+	close(listen_fd);
+	close(wake_fd);
+	close(epoll_fd);
+	listen_fd = wake_fd = epoll_fd = -1;
+}
+
+bool MjpegServer::hasClients(const std::string &name) {
+	int index = findStream(name);
+	return index >= 0 && streams[index]->clients > 0;
+}
+
+void MjpegServer::putFrame(const std::string &name, std::shared_ptr<const std::string> jpeg) {
+	int index = findStream(name);
+	if (index < 0 || !running)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(frame_mutex);
+		streams[index]->frame = jpeg;
+		streams[index]->frame_seq++;
+	}
+
+	uint64_t one = 1;
+	if (write(wake_fd, &one, sizeof(one)) < 0) {
+		// Counter is already non zero, the server thread is awake anyway.
+	}
+}
+
+int MjpegServer::findStream(const std::string &name) {
+	for (size_t i = 0; i < streams.size(); i++) {
+		if (streams[i]->name == name)
+			return i;
+	}
+	return -1;
+}
+
+void MjpegServer::run() {
+	epoll_event events[32];
+
+	while (running) {
+		int n = epoll_wait(epoll_fd, events, 32, 250);
+
+		for (int i = 0; i < n; i++) {
+			int fd = events[i].data.fd;
+
+			if (fd == listen_fd) {
+				acceptClients();
+				continue;
+			}
+
+			if (fd == wake_fd) {
+				uint64_t count;
+				if (read(wake_fd, &count, sizeof(count)) < 0) {
+					// Nothing to drain.
+				}
+				continue;
+			}
+
+			std::map<int, Client>::iterator it = clients.find(fd);
+			if (it == clients.end())
+				continue;
+
+			if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+				closeClient(fd);
+				continue;
+			}
+			if (events[i].events & EPOLLIN) {
+				readRequest(it->second);
+				// readRequest may have closed the client.
+				it = clients.find(fd);
+				if (it == clients.end())
+					continue;
+			}
+			if (events[i].events & EPOLLOUT)
+				writeClient(it->second);
+		}
+
+		// Hand the newest frame to every idle client and drop the ones that stopped reading.
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		std::vector<int> idle, stalled;
+		for (std::map<int, Client>::iterator it = clients.begin(); it != clients.end(); ++it) {
+			Client &client = it->second;
+			bool pending = client.stream < 0 || !client.header.empty() || client.frame;
+			if (pending) {
+				if (now - client.last_progress > client_timeout)
+					stalled.push_back(it->first);
+			}
+			else {
+				idle.push_back(it->first);
+			}
+		}
+
+		for (size_t i = 0; i < stalled.size(); i++)
+			closeClient(stalled[i]);
+
+		for (size_t i = 0; i < idle.size(); i++) {
+			std::map<int, Client>::iterator it = clients.find(idle[i]);
+			if (it != clients.end())
+				startFrame(it->second);
+		}
+	}
+}
+
+void MjpegServer::acceptClients() {
+	while (true) {
+		int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0)
+			return;
+
+		Client &client = clients[fd];
+		client.fd = fd;
+		client.last_progress = std::chrono::steady_clock::now();
+
+		epoll_event ev;
+		std::memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN | EPOLLRDHUP;
+		ev.data.fd = fd;
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+	}
+}
+
+void MjpegServer::readRequest(Client &client) {
+	char buf[1024];
+	ssize_t r = recv(client.fd, buf, sizeof(buf), 0);
+	if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+		closeClient(client.fd);
+		return;
+	}
+	if (r < 0 || client.stream >= 0 || !client.header.empty())
+		return;
+
+	client.request.append(buf, r);
+	if (client.request.find("\r\n\r\n") == std::string::npos) {
+		if (client.request.size() > max_request_size)
+			closeClient(client.fd);
+		return;
+	}
+
+	// Request line is "GET /<stream>[.mjpg][?query] HTTP/1.x".
+	std::string path;
+	size_t start = client.request.find(' ');
+	if (start != std::string::npos) {
+		size_t end = client.request.find(' ', start + 1);
+		if (end != std::string::npos)
+			path = client.request.substr(start + 1, end - start - 1);
+	}
+	bool is_get = client.request.compare(0, 4, "GET ") == 0;
+	client.request.clear();
+
+	size_t query = path.find('?');
+	if (query != std::string::npos)
+		path.erase(query);
+	if (!path.empty() && path[0] == '/')
+		path.erase(0, 1);
+	size_t ext = path.rfind(".mjpg");
+	if (ext != std::string::npos && ext == path.size() - 5)
+		path.erase(ext);
+
+	int index = findStream(path);
+	client.close_after_write = true;
+
+	if (!is_get) {
+		client.header = "HTTP/1.0 405 Method Not Allowed\r\nConnection: close\r\n\r\n";
+	}
+	else if (path.empty()) {
+		// Index page showing every stream.
+		std::string body = "<html><head><title>High Goal Vision</title></head><body>\n";
+		for (size_t i = 0; i < streams.size(); i++)
+			body += "<h3>" + streams[i]->name + "</h3><img src=\"/" + streams[i]->name + "\"><br>\n";
+		body += "</body></html>\n";
+		client.header = "HTTP/1.0 200 OK\r\nConnection: close\r\nContent-Type: text/html\r\nContent-Length: "
+				+ std::to_string(body.size()) + "\r\n\r\n" + body;
+	}
+	else if (index < 0) {
+		client.header = "HTTP/1.0 404 Not Found\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+	}
+	else {
+		client.close_after_write = false;
+		client.stream = index;
+		streams[index]->clients++;
+		client.header = std::string("HTTP/1.0 200 OK\r\n")
+				+ "Connection: close\r\n"
+				+ "Cache-Control: no-cache, no-store, must-revalidate\r\n"
+				+ "Pragma: no-cache\r\n"
+				+ "Content-Type: multipart/x-mixed-replace; boundary=" + boundary + "\r\n\r\n";
+	}
+
+	client.last_progress = std::chrono::steady_clock::now();
+	writeClient(client);
+}
+
+void MjpegServer::startFrame(Client &client) {
+	if (client.stream < 0)
+		return;
+
+	std::shared_ptr<const std::string> frame;
+	unsigned long frame_seq;
+	{
+		std::lock_guard<std::mutex> lock(frame_mutex);
+		frame = streams[client.stream]->frame;
+		frame_seq = streams[client.stream]->frame_seq;
+	}
+
+	// Nothing newer than what this client already has.
+	if (!frame || frame_seq == client.frame_seq)
+		return;
+
+	client.frame = frame;
+	client.frame_seq = frame_seq;
+	client.sent = 0;
+	client.header = std::string("--") + boundary + "\r\nContent-Type: image/jpeg\r\nContent-Length: "
+			+ std::to_string(frame->size()) + "\r\n\r\n";
+	client.last_progress = std::chrono::steady_clock::now();
+	writeClient(client);
+}
+
+void MjpegServer::writeClient(Client &client) {
+	while (true) {
+		// Pending output is header, then frame, then trailer, sent picks up where the last write stopped.
+		iovec iov[3];
+		int count = 0;
+		size_t offset = client.sent;
+		const char *bases[3] = {client.header.data(), NULL, frame_trailer};
+		size_t lengths[3] = {client.header.size(), 0, 0};
+		if (client.frame) {
+			bases[1] = client.frame->data();
+			lengths[1] = client.frame->size();
+			lengths[2] = sizeof(frame_trailer) - 1;
+		}
+		for (int i = 0; i < 3; i++) {
+			if (offset >= lengths[i]) {
+				offset -= lengths[i];
+				continue;
+			}
+			iov[count].iov_base = (void *) (bases[i] + offset);
+			iov[count].iov_len = lengths[i] - offset;
+			offset = 0;
+			count++;
+		}
+
+		if (count == 0)
+			break;
+
+		msghdr msg;
+		std::memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = count;
+		ssize_t r = sendmsg(client.fd, &msg, MSG_NOSIGNAL);
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				// Socket buffer is full, finish this frame when it drains.
+				watchWritable(client, true);
+				return;
+			}
+			closeClient(client.fd);
+			return;
+		}
+
+		client.sent += r;
+		client.last_progress = std::chrono::steady_clock::now();
+	}
+
+	// Done, release the frame so the buffer can be freed once every client is through with it.
+	client.header.clear();
+	client.frame.reset();
+	client.sent = 0;
+	watchWritable(client, false);
+
+	if (client.close_after_write)
+		closeClient(client.fd);
+}
+
+void MjpegServer::watchWritable(Client &client, bool writable) {
+	if (client.watching_writable == writable)
+		return;
+	client.watching_writable = writable;
+
+	epoll_event ev;
+	std::memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLRDHUP | (writable ? (uint32_t) EPOLLOUT : 0);
+	ev.data.fd = client.fd;
+	epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client.fd, &ev);
+}
+
+void MjpegServer::closeClient(int fd) {
+	std::map<int, Client>::iterator it = clients.find(fd);
+	if (it == clients.end())
+		return;
+
+	if (it->second.stream >= 0)
+		streams[it->second.stream]->clients--;
+
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+	close(fd);
+	clients.erase(it);
+}
@@ -0,0 +1,90 @@
+/*
+ * MjpegServer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#ifndef MJPEGSERVER_H_
+#define MJPEGSERVER_H_
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Minimal HTTP server that serves each registered stream as multipart MJPEG on
+// http://<host>:<port>/<stream name>. Runs on its own epoll thread.
+//
+// Frames are handed over as shared buffers and written straight from them to every
+// client, nothing is copied per client. A client still busy with an older frame skips
+// the frames in between and gets the newest one next, a client that makes no progress
+// for client_timeout is dropped.
+class MjpegServer {
+public:
+	MjpegServer(int port);
+	virtual ~MjpegServer();
+
+	// Register a stream, must be called before start().
+	void addStream(std::string name);
+	bool start();
+	void stop();
+
+	// True if a client is watching the stream, check this before encoding a frame.
+	bool hasClients(const std::string &name);
+	// Publish a JPEG frame to every client of the stream.
+	void putFrame(const std::string &name, std::shared_ptr<const std::string> jpeg);
+
+	int getPort() {return port;}
+
+private:
+	struct Stream {
+		std::string name;
+		std::atomic<int> clients;
+		std::shared_ptr<const std::string> frame;
+		unsigned long frame_seq = 0;
+	};
+
+	struct Client {
+		int fd;
+		int stream = -1;
+		std::string request;
+		bool close_after_write = false;
+		bool watching_writable = false;
+		// Pending output, a header followed by an optional frame and its trailer.
+		std::string header;
+		std::shared_ptr<const std::string> frame;
+		size_t sent = 0;
+		unsigned long frame_seq = 0;
+		std::chrono::steady_clock::time_point last_progress;
+	};
+
+	void run();
+	void acceptClients();
+	void readRequest(Client &client);
+	void startFrame(Client &client);
+	void writeClient(Client &client);
+	void watchWritable(Client &client, bool writable);
+	void closeClient(int fd);
+	int findStream(const std::string &name);
+
+	int port;
+	int listen_fd = -1;
+	int epoll_fd = -1;
+	int wake_fd = -1;
+	std::atomic<bool> running;
+	std::thread thread;
+
+	// Guards the frame and frame_seq of every stream.
+	std::mutex frame_mutex;
+	std::vector<std::unique_ptr<Stream> > streams;
+	std::map<int, Client> clients;
+
+	std::chrono::milliseconds client_timeout = std::chrono::milliseconds(2000);
+};
+
+#endif /* MJPEGSERVER_H_ */
@@ -46,3 +46,7 @@ double NetworkTablesClient::getData(llvm::StringRef data_name) {
 void NetworkTablesClient::putRaw(llvm::StringRef name, llvm::StringRef data){
 	table->PutRaw(name, data);
 }
+
+bool NetworkTablesClient::isConnected() {
+	return table->IsConnected();
+}
@@ -24,6 +24,7 @@ public:
 	llvm::StringRef getTableName() {return llvm::StringRef(table_name);}
 	double getData(llvm::StringRef);
 	void putRaw(llvm::StringRef, llvm::StringRef);
+	bool isConnected();
 
 private:
 	std::string table_name = "Vision";
@@ -0,0 +1,74 @@
+/*
+ * QualityGovernor.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#include "QualityGovernor.h"
+
+// Quality ladder, best first. Overlays and the dashboard stream go before anything that
+// affects the data sent to the robot, resolution and morphology passes go last.
+// The erode and dilate kernels are scaled with the processing scale (see scaledKernelSize), so
+// they cover the same camera pixels on every level and a lower level only costs precision, it
+// does not merge blobs into a different target. Every scale and pass count used here needs a
+// variant in the DetectorProfiles table.
+static const QualityLevel levels[] = {
+	// name,         scale, morph, depth, sd, overlays
+	{"full",         1.0,   2,     1,     1,  true},
+	{"no_overlay",   1.0,   2,     1,     2,  false},
+	{"reduced",      0.75,  2,     2,     3,  false},
+	{"half",         0.5,   1,     2,     5,  false},
+	{"minimal",      0.5,   1,     4,     0,  false},
+};
+
+static const int num_levels = sizeof(levels) / sizeof(levels[0]);
+
+QualityGovernor::QualityGovernor(double budget_ms) {
+	this->budget_ms = budget_ms;
+}
+
+QualityGovernor::~QualityGovernor() {
+}
+
+bool QualityGovernor::update(double frame_ms) {
+	if (frame_ms > budget_ms) {
+		over_count++;
+		under_count = 0;
+	}
+	else if (frame_ms < budget_ms * recover_fraction) {
+		under_count++;
+		over_count = 0;
+	}
+	else {
+		// Inside the dead band, hold the current level.
+		over_count = 0;
+		under_count = 0;
+	}
+
+	if (over_count >= degrade_after && level < num_levels - 1) {
+		level++;
+		over_count = 0;
+		return true;
+	}
+
+	if (under_count >= recover_after && level > 0) {
+		level--;
+		under_count = 0;
+		return true;
+	}
+
+	return false;
+}
+
+const QualityLevel &QualityGovernor::getLevel() {
+	return levels[level];
+}
+
+int QualityGovernor::getNumLevels() {
+	return num_levels;
+}
+
+const QualityLevel &QualityGovernor::getLevel(int index) {
+	return levels[index];
+}
@@ -0,0 +1,56 @@
+/*
+ * QualityGovernor.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#ifndef QUALITYGOVERNOR_H_
+#define QUALITYGOVERNOR_H_
+
+// One step on the quality ladder. Level 0 is full quality, each following level trades
+// accuracy or dashboard features for a shorter frame.
+struct QualityLevel {
+	const char *name;
+	double processingScale;	// Fraction of the camera resolution the threshold pipeline runs at.
+	int morphPasses;		// Number of erode and dilate passes in morphOps.
+	int depthInterval;		// Retrieve the depth measure every N frames.
+	int sdFrameDivisor;		// Divide sdFPS by this for the SmartDashboard stream, 0 turns the stream off.
+	bool drawOverlays;		// Draw the crosshair and status text on the image.
+};
+
+class QualityGovernor {
+public:
+	QualityGovernor(double budget_ms);
+	virtual ~QualityGovernor();
+
+	// Feed in the processing time of the last frame, returns true if the level changed.
+	bool update(double frame_ms);
+
+	const QualityLevel &getLevel();
+	int getLevelIndex() {return level;}
+	static int getNumLevels();
+
+	// The ladder is fixed, so any thread can look a level up by index.
+	static const QualityLevel &getLevel(int index);
+
+	double getBudget() {return budget_ms;}
+	void setBudget(double ms) {budget_ms = ms;}
+
+private:
+	double budget_ms;
+	int level = 0;
+
+	// Hysteresis counters, a level change needs a run of frames on the same side of the budget.
+	int over_count = 0;
+	int under_count = 0;
+
+	// Frames over budget before stepping down a level.
+	int degrade_after = 3;
+	// Frames comfortably under budget before stepping back up a level.
+	int recover_after = 60;
+	// Fraction of the budget a frame has to stay below to count towards recovery.
+	double recover_fraction = 0.6;
+};
+
+#endif /* QUALITYGOVERNOR_H_ */
@@ -0,0 +1,243 @@
+/*
+ * RealTime.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#include "RealTime.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <alloca.h>
+#include <dirent.h>
+#include <malloc.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+static cpu_set_t makeCpuSet(const std::vector<int> &cores) {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (size_t i = 0; i < cores.size(); i++)
+		CPU_SET(cores[i], &set);
+	return set;
+}
+
+bool pinThread(pthread_t thread, const std::vector<int> &cores) {
+	cpu_set_t set = makeCpuSet(cores);
+	int err = pthread_setaffinity_np(thread, sizeof(set), &set);
+	if (err != 0) {
+		std::cout << "Cannot set thread affinity: " << std::strerror(err) << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool setFifoPriority(pthread_t thread, int priority) {
+	sched_param param;
+	std::memset(&param, 0, sizeof(param));
+	param.sched_priority = priority;
+	int err = pthread_setschedparam(thread, SCHED_FIFO, &param);
+	if (err != 0) {
+		std::cout << "Cannot set SCHED_FIFO priority " << priority << ": " << std::strerror(err) << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int isolateOtherThreads(const std::vector<int> &cores) {
+	cpu_set_t set = makeCpuSet(cores);
+	pid_t self = syscall(SYS_gettid);
+	int moved = 0;
+
+	DIR *dir = opendir("/proc/self/task");
+	if (dir == NULL)
+		return 0;
+
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		pid_t tid = std::atoi(entry->d_name);
+		if (tid <= 0 || tid == self)
+			continue;
+		if (sched_setaffinity(tid, sizeof(set), &set) == 0)
+			moved++;
+	}
+	closedir(dir);
+	return moved;
+}
+
+void keepHeapMemory() {
+	// Keep freed memory in the heap instead of handing it back, and keep large allocations on
+	// the heap too, so a later allocation does not need fresh pages.
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+}
+
+bool lockMemory(size_t stack_bytes) {
+	keepHeapMemory();
+
+	// MCL_CURRENT also faults in every buffer allocated so far.
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+		std::cout << "Cannot lock memory: " << std::strerror(errno) << std::endl;
+		return false;
+	}
+
+	// Touch the stack the loop will use.
+	size_t page = sysconf(_SC_PAGESIZE);
+	volatile char *stack = (volatile char *) alloca(stack_bytes);
+	for (size_t i = 0; i < stack_bytes; i += page)
+		stack[i] = 0;
+
+	return true;
+}
+
+std::vector<int> otherCores(int core) {
+	std::vector<int> cores;
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	for (int i = 0; i < count; i++) {
+		if (i != core)
+			cores.push_back(i);
+	}
+	return cores;
+}
+
+JitterHistogram::JitterHistogram(double bucket_ms, int num_buckets, double deadline_ms) {
+	this->bucket_ms = bucket_ms;
+	this->deadline_ms = deadline_ms;
+	buckets.assign(num_buckets + 1, 0);
+}
+
+JitterHistogram::~JitterHistogram() {
+}
+
+void JitterHistogram::add(double ms) {
+	size_t bucket = ms < 0 ? 0 : (size_t) (ms / bucket_ms);
+	if (bucket >= buckets.size())
+		bucket = buckets.size() - 1;
+	buckets[bucket]++;
+	count++;
+	if (ms > deadline_ms)
+		misses++;
+	if (ms > max)
+		max = ms;
+}
+
+void JitterHistogram::reset() {
+	buckets.assign(buckets.size(), 0);
+	count = 0;
+	misses = 0;
+	max = 0;
+}
+
+double JitterHistogram::percentile(double fraction) {
+	long target = (long) (fraction * count);
+	long seen = 0;
+	for (size_t i = 0; i < buckets.size(); i++) {
+		seen += buckets[i];
+		if (seen > target)
+			return i == buckets.size() - 1 ? max : (i + 1) * bucket_ms;
+	}
+	return max;
+}
+
+void JitterHistogram::print(const std::string &name) {
+	std::cout << std::fixed << std::setprecision(2) << name << ": " << count << " samples, p50 " << percentile(0.5)
+			<< "ms, p99 " << percentile(0.99) << "ms, max " << max << "ms, " << misses << " over " << deadline_ms
+			<< "ms" << std::endl;
+
+	// Only print the populated part of the histogram.
+	long peak = 0;
+	for (size_t i = 0; i < buckets.size(); i++)
+		if (buckets[i] > peak) peak = buckets[i];
+	for (size_t i = 0; i < buckets.size() && peak > 0; i++) {
+		if (buckets[i] == 0)
+			continue;
+		std::cout << "  " << std::setw(7) << i * bucket_ms << (i == buckets.size() - 1 ? "+ ms " : "   ms ")
+				<< std::string(1 + buckets[i] * 50 / peak, '#') << " " << buckets[i] << std::endl;
+	}
+	std::cout.unsetf(std::ios::floatfield);
+	std::cout << std::setprecision(6);
+}
+
+LoopReporter::LoopReporter(void (*publish)(const FrameReport &), void (*report)(JitterHistogram &, JitterHistogram &),
+		const JitterHistogram &period, const JitterHistogram &latency)
+	: pending_period(period), pending_latency(latency), period(period), latency(latency) {
+	this->publish = publish;
+	this->report = report;
+}
+
+LoopReporter::~LoopReporter() {
+	stop();
+}
+
+void LoopReporter::start() {
+	if (running)
+		return;
+	running = true;
+	thread = std::thread(&LoopReporter::run, this);
+}
+
+void LoopReporter::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!running)
+			return;
+		running = false;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+void LoopReporter::putFrame(const FrameReport &frame) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		bool changed = fresh_frame && pending_frame.quality_changed;
+		pending_frame = frame;
+		pending_frame.quality_changed = frame.quality_changed || changed;
+		fresh_frame = true;
+	}
+	wake.notify_one();
+}
+
+void LoopReporter::putJitter(const JitterHistogram &period, const JitterHistogram &latency) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		// Same bucket count, so the copies reuse the buffers.
+		pending_period = period;
+		pending_latency = latency;
+		fresh_jitter = true;
+	}
+	wake.notify_one();
+}
+
+void LoopReporter::run() {
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (true) {
+		wake.wait(lock, [this] {return !running || fresh_frame || fresh_jitter;});
+		if (!running)
+			return;
+
+		bool have_frame = fresh_frame;
+		bool have_jitter = fresh_jitter;
+		if (have_frame)
+			frame = pending_frame;
+		if (have_jitter) {
+			period = pending_period;
+			latency = pending_latency;
+		}
+		fresh_frame = false;
+		fresh_jitter = false;
+
+		lock.unlock();
+		if (have_frame)
+			publish(frame);
+		if (have_jitter)
+			report(period, latency);
+		lock.lock();
+	}
+}
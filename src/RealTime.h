@@ -0,0 +1,113 @@
+/*
+ * RealTime.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#ifndef REALTIME_H_
+#define REALTIME_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include "TargetDetector.h"
+
+// Core affinity, SCHED_FIFO and memory locking for the capture/detect loop. Everything here
+// needs root or CAP_SYS_NICE / CAP_IPC_LOCK, failures are reported and otherwise ignored.
+bool pinThread(pthread_t thread, const std::vector<int> &cores);
+bool setFifoPriority(pthread_t thread, int priority);
+
+// Move every thread of the process except the calling one onto cores, e.g. the NetworkTables
+// and MJPEG server threads. Returns the number of threads moved.
+int isolateOtherThreads(const std::vector<int> &cores);
+
+// Keep freed memory in the heap, so buffers reallocated after lockMemory reuse locked pages.
+void keepHeapMemory();
+
+// Lock all current and future memory and fault in stack_bytes of stack, so the loop never
+// takes a page fault. Call it once the loop has allocated its buffers.
+bool lockMemory(size_t stack_bytes);
+
+// Every core of the machine except the given one.
+std::vector<int> otherCores(int core);
+
+// Histogram of loop periods or latencies in milliseconds, with a deadline miss counter.
+class JitterHistogram {
+public:
+	JitterHistogram(double bucket_ms, int num_buckets, double deadline_ms);
+	virtual ~JitterHistogram();
+
+	void add(double ms);
+	void reset();
+
+	// Upper edge of the bucket holding the given fraction of samples, 0.5 for the median.
+	double percentile(double fraction);
+	double getMax() {return max;}
+	long getMisses() {return misses;}
+	long getCount() {return count;}
+
+	void print(const std::string &name);
+
+private:
+	double bucket_ms;
+	double deadline_ms;
+	// The last bucket collects everything above the range.
+	std::vector<long> buckets;
+	long count = 0;
+	long misses = 0;
+	double max = 0;
+};
+
+// Results of one frame of the loop, for publishing. Plain values, so handing it over never allocates.
+struct FrameReport {
+	TargetStatus status;
+	Target target;			// Valid if status is TARGET_FOUND.
+	float depth;			// ZED depth measure at the target centroid.
+	int quality_level;
+	bool quality_changed;	// The governor changed the level after this frame.
+	double frame_ms;
+};
+
+// Hands the loop's frame results and jitter histograms to a thread of its own for publishing
+// and printing, so the real time loop only copies them. Start it before isolateOtherThreads so
+// it gets moved too.
+class LoopReporter {
+public:
+	// The histograms give the bucket layout, copies are made into buffers of the same size.
+	LoopReporter(void (*publish)(const FrameReport &), void (*report)(JitterHistogram &, JitterHistogram &),
+			const JitterHistogram &period, const JitterHistogram &latency);
+	virtual ~LoopReporter();
+
+	void start();
+	void stop();
+
+	// Queue the results of a frame, a frame still waiting is replaced. A level change of a
+	// replaced frame is carried over.
+	void putFrame(const FrameReport &frame);
+
+	// Queue copies of both histograms, a report still waiting is replaced.
+	void putJitter(const JitterHistogram &period, const JitterHistogram &latency);
+
+private:
+	void run();
+
+	void (*publish)(const FrameReport &);
+	void (*report)(JitterHistogram &, JitterHistogram &);
+
+	bool running = false;
+	bool fresh_frame = false;
+	bool fresh_jitter = false;
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+	// Written by the put functions, then copied by the reporter thread.
+	FrameReport pending_frame, frame;
+	JitterHistogram pending_period, pending_latency;
+	JitterHistogram period, latency;
+};
+
+#endif /* REALTIME_H_ */
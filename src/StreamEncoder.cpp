@@ -0,0 +1,92 @@
+/*
+ * StreamEncoder.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#include "StreamEncoder.h"
+#include <opencv2/imgproc.hpp>
+
+StreamEncoder::StreamEncoder(MjpegServer *server, std::string (*encode)(cv::Mat), cv::Size size) {
+	this->server = server;
+	this->encode = encode;
+	this->size = size;
+}
+
+StreamEncoder::~StreamEncoder() {
+	stop();
+}
+
+void StreamEncoder::addStream(const std::string &name, int type) {
+	pending[name].image.create(size, type);
+	encoding[name].image.create(size, type);
+}
+
+void StreamEncoder::addMaskStream(const std::string &name, void (*publish)(const cv::Mat &mask)) {
+	addStream(name, CV_8UC1);
+	pending[name].publish = publish;
+	encoding[name].publish = publish;
+}
+
+void StreamEncoder::start() {
+	if (running)
+		return;
+	running = true;
+	thread = std::thread(&StreamEncoder::run, this);
+}
+
+void StreamEncoder::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!running)
+			return;
+		running = false;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+void StreamEncoder::put(const std::string &name, const cv::Mat &image) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::map<std::string, Slot>::iterator it = pending.find(name);
+		if (it == pending.end())
+			return;
+
+		// Only the stream size is copied, into the buffer allocated by addStream.
+		Slot &slot = it->second;
+		cv::resize(image, slot.image, size, 0, 0, slot.publish ? cv::INTER_NEAREST : cv::INTER_LINEAR);
+		if (!slot.fresh)
+			fresh_count++;
+		slot.fresh = true;
+	}
+	wake.notify_one();
+}
+
+void StreamEncoder::run() {
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (true) {
+		wake.wait(lock, [this] {return !running || fresh_count > 0;});
+		if (!running)
+			return;
+
+		// The slots encoded last time become the ones put() fills next.
+		encoding.swap(pending);
+		fresh_count = 0;
+
+		lock.unlock();
+		for (std::map<std::string, Slot>::iterator it = encoding.begin(); it != encoding.end(); ++it) {
+			Slot &slot = it->second;
+			if (!slot.fresh)
+				continue;
+			if (slot.publish)
+				slot.publish(slot.image);
+			else
+				server->putFrame(it->first, std::make_shared<std::string>(encode(slot.image)));
+			slot.fresh = false;
+		}
+		lock.lock();
+	}
+}
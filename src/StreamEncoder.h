@@ -0,0 +1,66 @@
+/*
+ * StreamEncoder.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#ifndef STREAMENCODER_H_
+#define STREAMENCODER_H_
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <opencv2/core.hpp>
+#include "MjpegServer.h"
+
+// JPEG encodes the dashboard streams on its own thread and hands them to the MJPEG server, so
+// the encode never runs on the detect core. Only the newest frame of each stream is kept, a
+// frame still waiting when the next one arrives is dropped. Frames are scaled down to the
+// stream size when queued, into two buffers per stream that are allocated when the stream is
+// added and reused from frame to frame.
+class StreamEncoder {
+public:
+	StreamEncoder(MjpegServer *server, std::string (*encode)(cv::Mat), cv::Size size);
+	virtual ~StreamEncoder();
+
+	// Register a JPEG stream of images of type, before start().
+	void addStream(const std::string &name, int type);
+
+	// Register a binary mask stream, before start(). Its frames are resized with INTER_NEAREST
+	// so they stay binary and are handed to publish on the worker thread instead of the MJPEG
+	// server, e.g. for the run length coded threshold mask.
+	void addMaskStream(const std::string &name, void (*publish)(const cv::Mat &mask));
+
+	void start();
+	void stop();
+
+	// Queue a copy of image, resized to the stream size, for the named stream.
+	void put(const std::string &name, const cv::Mat &image);
+
+private:
+	void run();
+
+	MjpegServer *server;
+	std::string (*encode)(cv::Mat);
+	cv::Size size;
+
+	struct Slot {
+		cv::Mat image;
+		bool fresh = false;
+		void (*publish)(const cv::Mat &mask) = NULL;	// NULL for a JPEG stream.
+	};
+
+	bool running = false;
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+	// put() writes into pending, the worker swaps it with encoding and encodes the fresh slots.
+	std::map<std::string, Slot> pending;
+	std::map<std::string, Slot> encoding;
+	int fresh_count = 0;
+};
+
+#endif /* STREAMENCODER_H_ */
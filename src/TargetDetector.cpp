@@ -0,0 +1,231 @@
+/*
+ * TargetDetector.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#include "TargetDetector.h"
+#include <algorithm>
+#include <vector>
+#include <opencv2/imgproc.hpp>
+
+// Stripes labelBlobs splits the image into, fixed so the result does not depend on thread count.
+static const int LABEL_STRIPES = 16;
+
+// Provisional labels of one stripe, a union-find where every root is the smallest label of its set.
+struct StripeLabels {
+	int y0, y1;
+	std::vector<int> parent;
+	std::vector<Blob> stats;
+};
+
+static int findRoot(std::vector<int> &parent, int label) {
+	while (parent[label] != label) {
+		parent[label] = parent[parent[label]];
+		label = parent[label];
+	}
+	return label;
+}
+
+static void unite(std::vector<int> &parent, int a, int b) {
+	a = findRoot(parent, a);
+	b = findRoot(parent, b);
+	if (a < b)
+		parent[b] = a;
+	else if (b < a)
+		parent[a] = b;
+}
+
+static void addBlob(Blob &into, const Blob &from) {
+	into.area += from.area;
+	into.sum_x += from.sum_x;
+	into.sum_y += from.sum_y;
+	into.left = std::min(into.left, from.left);
+	into.top = std::min(into.top, from.top);
+	into.right = std::max(into.right, from.right);
+	into.bottom = std::max(into.bottom, from.bottom);
+}
+
+// One pass over each stripe, only looking at the rows of that stripe.
+class LabelStripes : public cv::ParallelLoopBody {
+public:
+	LabelStripes(const cv::Mat &mask, cv::Mat &labels, std::vector<StripeLabels> &stripes)
+		: mask(mask), labels(labels), stripes(stripes) {}
+
+	void operator()(const cv::Range &range) const {
+		for (int i = range.start; i < range.end; i++)
+			label(stripes[i]);
+	}
+
+private:
+	void label(StripeLabels &s) const {
+		int cols = mask.cols;
+		s.parent.assign(1, 0);
+		s.stats.assign(1, Blob());
+
+		for (int y = s.y0; y < s.y1; y++) {
+			const uchar *m = mask.ptr<uchar>(y);
+			int *l = labels.ptr<int>(y);
+			const int *up = y > s.y0 ? labels.ptr<int>(y - 1) : NULL;
+
+			for (int x = 0; x < cols; x++) {
+				if (!m[x]) {
+					l[x] = 0;
+					continue;
+				}
+
+				// Neighbours already visited: left, up left, up, up right.
+				int neighbours[4] = {
+					x > 0 ? l[x - 1] : 0,
+					up && x > 0 ? up[x - 1] : 0,
+					up ? up[x] : 0,
+					up && x + 1 < cols ? up[x + 1] : 0
+				};
+				int label = 0;
+				for (int k = 0; k < 4; k++) {
+					if (!neighbours[k])
+						continue;
+					if (!label)
+						label = neighbours[k];
+					else if (neighbours[k] != label)
+						unite(s.parent, label, neighbours[k]);
+				}
+
+				if (!label) {
+					label = s.parent.size();
+					s.parent.push_back(label);
+					Blob blob = {0, 0, 0, x, y, x, y};
+					s.stats.push_back(blob);
+				}
+
+				l[x] = label;
+				Blob &blob = s.stats[label];
+				blob.area++;
+				blob.sum_x += x;
+				blob.sum_y += y;
+				blob.left = std::min(blob.left, x);
+				blob.right = std::max(blob.right, x);
+				blob.bottom = y;
+			}
+		}
+
+		// Roots are the smallest label of their set, so folding in label order always moves
+		// statistics down to a label that is already final.
+		for (size_t label = 1; label < s.parent.size(); label++) {
+			int root = findRoot(s.parent, label);
+			if (root != (int) label)
+				addBlob(s.stats[root], s.stats[label]);
+		}
+	}
+
+	const cv::Mat &mask;
+	cv::Mat &labels;
+	std::vector<StripeLabels> &stripes;
+};
+
+void labelBlobs(const cv::Mat &mask, std::vector<Blob> &blobs) {
+	blobs.clear();
+	int num_stripes = std::min(LABEL_STRIPES, mask.rows);
+	if (num_stripes == 0)
+		return;
+
+	std::vector<StripeLabels> stripes(num_stripes);
+	for (int i = 0; i < num_stripes; i++) {
+		stripes[i].y0 = i * mask.rows / num_stripes;
+		stripes[i].y1 = (i + 1) * mask.rows / num_stripes;
+	}
+
+	cv::Mat labels(mask.size(), CV_32SC1);
+	cv::parallel_for_(cv::Range(0, num_stripes), LabelStripes(mask, labels, stripes));
+
+	// Number the provisional labels of all stripes one after the other.
+	std::vector<int> offset(num_stripes + 1, 0);
+	for (int i = 0; i < num_stripes; i++)
+		offset[i + 1] = offset[i] + stripes[i].parent.size();
+
+	std::vector<int> parent(offset[num_stripes]);
+	for (size_t i = 0; i < parent.size(); i++)
+		parent[i] = i;
+
+	// Merge blobs that touch across each stripe boundary, 8-connected.
+	for (int i = 0; i + 1 < num_stripes; i++) {
+		int y = stripes[i + 1].y0;
+		const int *upper = labels.ptr<int>(y - 1);
+		const int *lower = labels.ptr<int>(y);
+		for (int x = 0; x < mask.cols; x++) {
+			if (!upper[x])
+				continue;
+			int a = offset[i] + findRoot(stripes[i].parent, upper[x]);
+			for (int dx = -1; dx <= 1; dx++) {
+				int xx = x + dx;
+				if (xx < 0 || xx >= mask.cols || !lower[xx])
+					continue;
+				unite(parent, a, offset[i + 1] + findRoot(stripes[i + 1].parent, lower[xx]));
+			}
+		}
+	}
+
+	// Collect the statistics of every stripe root into its merged blob, in stripe order.
+	std::vector<int> blob_index(parent.size(), -1);
+	for (int i = 0; i < num_stripes; i++) {
+		StripeLabels &s = stripes[i];
+		for (size_t label = 1; label < s.parent.size(); label++) {
+			if (s.parent[label] != (int) label)
+				continue;
+			int root = findRoot(parent, offset[i] + label);
+			if (blob_index[root] < 0) {
+				blob_index[root] = blobs.size();
+				blobs.push_back(s.stats[label]);
+			}
+			else {
+				addBlob(blobs[blob_index[root]], s.stats[label]);
+			}
+		}
+	}
+}
+
+ContourBuffers &contourBuffers() {
+	static thread_local ContourBuffers buffers;
+	return buffers;
+}
+
+TargetStatus findTarget(const cv::Mat &threshold, double scale, const TargetLimits &limits, Target &target) {
+	//the copy and the two vectors needed for output of findContours, reused from the last call
+	ContourBuffers &buffers = contourBuffers();
+	threshold.copyTo(buffers.temp);
+	//find contours of filtered image using openCV findContours function
+	findContours(buffers.temp, buffers.contours, buffers.hierarchy, CV_RETR_CCOMP, CV_CHAIN_APPROX_SIMPLE);
+
+	return selectTarget(buffers.contours, buffers.hierarchy, scale, limits, target);
+}
+
+TargetStatus findTargetBlobs(const cv::Mat &threshold, double scale, const TargetLimits &limits, Target &target) {
+	std::vector<Blob> blobs;
+	labelBlobs(threshold, blobs);
+
+	if (blobs.empty())
+		return TARGET_NONE;
+
+	//if number of objects greater than max_objects we have a noisy filter
+	if ((int) blobs.size() >= limits.max_objects)
+		return TARGET_NOISY;
+
+	//largest blob inside the area limits, areas are compared at camera resolution
+	int best = -1;
+	for (size_t i = 0; i < blobs.size(); i++) {
+		double fullArea = blobs[i].area / (scale * scale);
+		if (fullArea > limits.min_area && fullArea < limits.max_area && (best < 0 || blobs[i].area > blobs[best].area))
+			best = i;
+	}
+
+	if (best < 0)
+		return TARGET_NONE;
+
+	//INTER_NEAREST takes processing pixel x from camera pixel floor(x / scale), map back the same way
+	const Blob &blob = blobs[best];
+	target.centroid.x = (double) blob.sum_x / blob.area / scale;
+	target.centroid.y = (double) blob.sum_y / blob.area / scale;
+	target.area = blob.area / (scale * scale);
+	return TARGET_FOUND;
+}
@@ -0,0 +1,160 @@
+/*
+ * TargetDetector.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#ifndef TARGETDETECTOR_H_
+#define TARGETDETECTOR_H_
+
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+enum TargetStatus {
+	TARGET_NONE,
+	TARGET_FOUND,
+	TARGET_NOISY	// More than max_objects blobs, the filter needs adjusting.
+};
+
+//max number of objects to be detected in frame
+const int MAX_NUM_OBJECTS = 50;
+
+//minimum and maximum object area, the maximum relative to a 720x404 image
+const int MIN_OBJECT_AREA = 1 * 1;
+const int MAX_OBJECT_AREA = 720 * 404 / 1.5;
+
+struct TargetLimits {
+	int max_objects;
+	double min_area;	// In camera pixels.
+	double max_area;
+};
+
+struct Target {
+	cv::Point2d centroid;	// Sub-pixel, in camera pixels.
+	double area;			// In camera pixels.
+};
+
+// Pixel statistics of one 8-connected blob.
+struct Blob {
+	long area;
+	long sum_x, sum_y;	// First order moments, the centroid is sum / area.
+	int left, top, right, bottom;	// Inclusive bounds.
+};
+
+// Buffers of a contour search. Every thread reuses its own from call to call, so once the first
+// frame has grown them the detect loop stops allocating them. findContours still uses its own
+// internal storage.
+struct ContourBuffers {
+	cv::Mat temp;	// findContours modifies its input.
+	std::vector<std::vector<cv::Point> > contours;
+	std::vector<cv::Vec4i> hierarchy;
+};
+
+// The buffers of the calling thread.
+ContourBuffers &contourBuffers();
+
+// Label the 8-connected blobs of a binary image. Horizontal stripes are labelled in parallel and
+// their blobs merged where they touch across a stripe boundary. Blob order and statistics do not
+// depend on the number of threads.
+void labelBlobs(const cv::Mat &mask, std::vector<Blob> &blobs);
+
+// Pick the largest top level contour inside the area limits. Limits is TargetLimits, or a detector
+// profile with the same members as compile time constants.
+template <class Limits>
+TargetStatus selectTarget(const std::vector<std::vector<cv::Point> > &contours, const std::vector<cv::Vec4i> &hierarchy,
+		double scale, const Limits &limits, Target &target) {
+	if (hierarchy.size() == 0)
+		return TARGET_NONE;
+
+	//if number of objects greater than max_objects we have a noisy filter
+	int numObjects = hierarchy.size();
+	if (numObjects >= limits.max_objects)
+		return TARGET_NOISY;
+
+	//use moments method to find our filtered object
+	double refArea = 0;
+	bool objectFound = false;
+	for (int index = 0; index >= 0; index = hierarchy[index][0]) {
+
+		cv::Moments moment = moments((cv::Mat)contours[index]);
+		double area = moment.m00;
+
+		//if the area is less than min_area then it is probably just noise
+		//if the area is more than max_area, probably just a bad filter
+		//we only want the object with the largest area so we save a reference area each
+		//iteration and compare it to the area in the next iteration.
+		//areas are compared at camera resolution
+		double fullArea = area / (scale * scale);
+		if (fullArea>limits.min_area && fullArea<limits.max_area && area>refArea){
+			//INTER_NEAREST takes processing pixel x from camera pixel floor(x / scale), map back the same way
+			target.centroid.x = moment.m10 / area / scale;
+			target.centroid.y = moment.m01 / area / scale;
+			target.area = fullArea;
+			objectFound = true;
+			refArea = area;
+		}
+		else {
+			objectFound = false;
+		}
+	}
+
+	return objectFound ? TARGET_FOUND : TARGET_NONE;
+}
+
+// Pick the two largest top level contours inside the area limits, for a target made of two
+// strips. The centroid is the midpoint between the strip centroids and the area is their sum.
+template <class Limits>
+TargetStatus selectStripPair(const std::vector<std::vector<cv::Point> > &contours, const std::vector<cv::Vec4i> &hierarchy,
+		double scale, const Limits &limits, Target &target) {
+	if (hierarchy.size() == 0)
+		return TARGET_NONE;
+
+	int numObjects = hierarchy.size();
+	if (numObjects >= limits.max_objects)
+		return TARGET_NOISY;
+
+	// strips[0] is the largest so far.
+	Target strips[2];
+	int found = 0;
+	for (int index = 0; index >= 0; index = hierarchy[index][0]) {
+		cv::Moments moment = moments((cv::Mat)contours[index]);
+		double area = moment.m00;
+		double fullArea = area / (scale * scale);
+		if (!(fullArea>limits.min_area && fullArea<limits.max_area))
+			continue;
+
+		//INTER_NEAREST takes processing pixel x from camera pixel floor(x / scale), map back the same way
+		Target strip;
+		strip.centroid.x = moment.m10 / area / scale;
+		strip.centroid.y = moment.m01 / area / scale;
+		strip.area = fullArea;
+
+		if (found == 0 || strip.area > strips[0].area) {
+			strips[1] = strips[0];
+			strips[0] = strip;
+		}
+		else if (found == 1 || strip.area > strips[1].area)
+			strips[1] = strip;
+		found++;
+	}
+
+	if (found < 2)
+		return TARGET_NONE;
+
+	target.centroid.x = (strips[0].centroid.x + strips[1].centroid.x) / 2;
+	target.centroid.y = (strips[0].centroid.y + strips[1].centroid.y) / 2;
+	target.area = strips[0].area + strips[1].area;
+	return TARGET_FOUND;
+}
+
+// Find the largest blob in the threshold image inside the area limits. The threshold image may be
+// at a lower resolution than the camera, scale is threshold width / camera width.
+TargetStatus findTarget(const cv::Mat &threshold, double scale, const TargetLimits &limits, Target &target);
+
+// Same as findTarget, but from labelBlobs instead of findContours. Areas are pixel counts rather
+// than contour areas, and every blob counts towards max_objects, so results can differ slightly.
+TargetStatus findTargetBlobs(const cv::Mat &threshold, double scale, const TargetLimits &limits, Target &target);
+
+#endif /* TARGETDETECTOR_H_ */
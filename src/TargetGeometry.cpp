@@ -0,0 +1,80 @@
+/*
+ * TargetGeometry.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#include "TargetGeometry.h"
+#include <cmath>
+#include <vector>
+#include <opencv2/imgproc.hpp>
+
+static const double deg_to_rad = CV_PI / 180.0;
+
+TargetGeometry::TargetGeometry() {
+	// Identity intrinsics until the calibration is set, normalise() then returns pixels.
+	camera_matrix = cv::Matx33d::eye();
+	dist_coeffs = cv::Mat::zeros(1, 5, CV_64F);
+	mount_rotation = cv::Matx33d::eye();
+}
+
+TargetGeometry::~TargetGeometry() {
+}
+
+void TargetGeometry::setCalibration(double fx, double fy, double cx, double cy, const double disto[5]) {
+	camera_matrix = cv::Matx33d(fx, 0, cx,
+								0, fy, cy,
+								0, 0, 1);
+	for (int i = 0; i < 5; i++)
+		dist_coeffs.at<double>(0, i) = disto[i];
+}
+
+void TargetGeometry::setMountPose(double x, double y, double z, double yaw, double pitch, double roll) {
+	double cy = std::cos(yaw * deg_to_rad), sy = std::sin(yaw * deg_to_rad);
+	// Positive pitch tilts the camera up, which is a negative rotation about the robot y axis.
+	double cp = std::cos(-pitch * deg_to_rad), sp = std::sin(-pitch * deg_to_rad);
+	double cr = std::cos(roll * deg_to_rad), sr = std::sin(roll * deg_to_rad);
+
+	cv::Matx33d rz(cy, -sy, 0,
+				   sy, cy, 0,
+				   0, 0, 1);
+	cv::Matx33d ry(cp, 0, sp,
+				   0, 1, 0,
+				   -sp, 0, cp);
+	cv::Matx33d rx(1, 0, 0,
+				   0, cr, -sr,
+				   0, sr, cr);
+	// Swap camera axes (x right, y down, z forward) to robot axes (x forward, y left, z up).
+	cv::Matx33d axes(0, 0, 1,
+					 -1, 0, 0,
+					 0, -1, 0);
+
+	mount_rotation = rz * ry * rx * axes;
+	mount_translation = cv::Vec3d(x, y, z);
+	has_mount = true;
+}
+
+cv::Point2d TargetGeometry::normalise(cv::Point2d pixel) {
+	std::vector<cv::Point2d> src(1, pixel), dst;
+	cv::undistortPoints(src, dst, cv::Mat(camera_matrix), dist_coeffs);
+	return dst[0];
+}
+
+double TargetGeometry::yaw(cv::Point2d normalised) {
+	return std::atan(normalised.x) / deg_to_rad;
+}
+
+double TargetGeometry::pitch(cv::Point2d normalised) {
+	// Measured from the horizontal plane through the camera, so it stays correct off centre.
+	return std::atan2(-normalised.y, std::sqrt(1 + normalised.x * normalised.x)) / deg_to_rad;
+}
+
+cv::Point3d TargetGeometry::cameraPosition(cv::Point2d normalised, double depth) {
+	return cv::Point3d(normalised.x * depth, normalised.y * depth, depth);
+}
+
+cv::Point3d TargetGeometry::robotPosition(cv::Point3d camera) {
+	cv::Vec3d robot = mount_rotation * cv::Vec3d(camera.x, camera.y, camera.z) + mount_translation;
+	return cv::Point3d(robot[0], robot[1], robot[2]);
+}
@@ -0,0 +1,51 @@
+/*
+ * TargetGeometry.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#ifndef TARGETGEOMETRY_H_
+#define TARGETGEOMETRY_H_
+
+#include <opencv2/core.hpp>
+
+// Turns target pixels into angles and positions using the camera calibration. Only the target
+// points are undistorted, the image itself is never remapped.
+//
+// Camera frame: x right, y down, z forward, in meters.
+// Robot frame:  x forward, y left, z up, in meters.
+class TargetGeometry {
+public:
+	TargetGeometry();
+	virtual ~TargetGeometry();
+
+	// Intrinsics and distortion (k1, k2, p1, p2, k3) of the image targets are found in.
+	void setCalibration(double fx, double fy, double cx, double cy, const double disto[5]);
+
+	// Camera position on the robot in meters and its yaw (positive left), pitch (positive up)
+	// and roll in degrees.
+	void setMountPose(double x, double y, double z, double yaw, double pitch, double roll);
+	bool hasMountPose() {return has_mount;}
+
+	// Undistorted normalised image coordinates, x / z and y / z in the camera frame.
+	cv::Point2d normalise(cv::Point2d pixel);
+
+	// Angle to the target in degrees, yaw positive to the right and pitch positive up.
+	double yaw(cv::Point2d normalised);
+	double pitch(cv::Point2d normalised);
+
+	// Position of the target from its normalised coordinates and ZED depth, which is z.
+	cv::Point3d cameraPosition(cv::Point2d normalised, double depth);
+	cv::Point3d robotPosition(cv::Point3d camera);
+
+private:
+	cv::Matx33d camera_matrix;
+	cv::Mat dist_coeffs;
+
+	bool has_mount = false;
+	cv::Matx33d mount_rotation;
+	cv::Vec3d mount_translation;
+};
+
+#endif /* TARGETGEOMETRY_H_ */
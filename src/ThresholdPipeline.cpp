@@ -0,0 +1,235 @@
+/*
+ * ThresholdPipeline.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#include "ThresholdPipeline.h"
+#include <opencv2/imgproc.hpp>
+
+static cv::Rect grow(cv::Rect r, int by, cv::Size bounds) {
+	return cv::Rect(r.x - by, r.y - by, r.width + 2 * by, r.height + 2 * by) & cv::Rect(cv::Point(0, 0), bounds);
+}
+
+int scaledKernelSize(int size, double scale) {
+	return scaledKernelSizePercent(size, cvRound(scale * 100));
+}
+
+void morphOps(cv::Mat &thresh, int passes, double scale){
+
+	//create structuring element that will be used to "dilate" and "erode" image.
+	//the element chosen here is a 3px by 3px rectangle at camera resolution
+	int erodeSize = scaledKernelSize(ERODE_SIZE, scale);
+	int dilateSize = scaledKernelSize(DILATE_SIZE, scale);
+
+	cv::Mat erodeElement = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(erodeSize, erodeSize));
+	//dilate with larger element so make sure object is nicely visible
+	cv::Mat dilateElement = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(dilateSize, dilateSize));
+
+	for (int i = 0; i < passes; i++)
+		cv::erode(thresh, thresh, erodeElement);
+
+	for (int i = 0; i < passes; i++)
+		cv::dilate(thresh, thresh, dilateElement);
+
+}
+
+int morphHalo(int passes, double scale) {
+	// Kernels are anchored in the middle, an even sized one reaches size / 2 on one side.
+	return passes * (scaledKernelSize(ERODE_SIZE, scale) / 2 + scaledKernelSize(DILATE_SIZE, scale) / 2);
+}
+
+static cv::Mat &morphRegionBuffer() {
+	static thread_local cv::Mat buffer;
+	return buffer;
+}
+
+void reserveMorphRegion(cv::Size size) {
+	cv::Mat &buffer = morphRegionBuffer();
+	if (buffer.cols < size.width || buffer.rows < size.height)
+		buffer.create(size, CV_8UC1);
+}
+
+void morphRegion(const cv::Mat &raw, cv::Rect out, int passes, double scale, cv::Mat &morphed) {
+	// Pixels near the edge of the copy are wrong unless that edge is also the image edge, the halo
+	// keeps them out of out.
+	cv::Rect in = grow(out, morphHalo(passes, scale), raw.size());
+	// A header of its own over the buffer memory and not a region of the buffer, so erode and
+	// dilate see no pixels around it.
+	reserveMorphRegion(raw.size());
+	cv::Mat region(in.size(), CV_8UC1, morphRegionBuffer().data);
+	raw(in).copyTo(region);
+	morphOps(region, passes, scale);
+
+	cv::Mat dst = morphed(out);
+	region(out - in.tl()).copyTo(dst);
+}
+
+static cv::Rect stripeRect(int stripe, int stripes, cv::Size size) {
+	int y0 = stripe * size.height / stripes;
+	int y1 = (stripe + 1) * size.height / stripes;
+	return cv::Rect(0, y0, size.width, y1 - y0);
+}
+
+// First pass, per pixel so stripes need no halo.
+class ThresholdStripes : public cv::ParallelLoopBody {
+public:
+	ThresholdStripes(const cv::Mat &frame, cv::Scalar lower, cv::Scalar upper, cv::Mat &hsv, cv::Mat &raw)
+		: frame(frame), lower(lower), upper(upper), hsv(hsv), raw(raw) {}
+
+	void operator()(const cv::Range &range) const {
+		for (int i = range.start; i < range.end; i++) {
+			cv::Rect stripe = stripeRect(i, THRESHOLD_STRIPES, frame.size());
+			if (stripe.height == 0)
+				continue;
+			cv::Mat hsv_stripe = hsv(stripe);
+			cv::Mat raw_stripe = raw(stripe);
+			cvtColor(frame(stripe), hsv_stripe, cv::COLOR_BGR2HSV);
+			inRange(hsv_stripe, lower, upper, raw_stripe);
+		}
+	}
+
+private:
+	const cv::Mat &frame;
+	cv::Scalar lower, upper;
+	cv::Mat &hsv;
+	cv::Mat &raw;
+};
+
+// Second pass, each stripe reads the halo rows of its neighbours from the finished first pass.
+class MorphStripes : public cv::ParallelLoopBody {
+public:
+	MorphStripes(const cv::Mat &raw, int passes, double scale, cv::Mat &morphed)
+		: raw(raw), passes(passes), scale(scale), morphed(morphed) {}
+
+	void operator()(const cv::Range &range) const {
+		for (int i = range.start; i < range.end; i++) {
+			cv::Rect stripe = stripeRect(i, THRESHOLD_STRIPES, raw.size());
+			if (stripe.height > 0)
+				morphRegion(raw, stripe, passes, scale, morphed);
+		}
+	}
+
+private:
+	const cv::Mat &raw;
+	int passes;
+	double scale;
+	cv::Mat &morphed;
+};
+
+class NoWork : public cv::ParallelLoopBody {
+public:
+	void operator()(const cv::Range &) const {}
+};
+
+ParallelThreshold::ParallelThreshold() {
+}
+
+ParallelThreshold::~ParallelThreshold() {
+}
+
+void ParallelThreshold::process(const cv::Mat &frame, cv::Scalar lower, cv::Scalar upper, int passes, double scale, cv::Mat &threshold) {
+	// Stripes write into these, so they must not be reallocated inside the loop.
+	hsv.create(frame.size(), CV_8UC3);
+	raw.create(frame.size(), CV_8UC1);
+	cv::parallel_for_(cv::Range(0, THRESHOLD_STRIPES), ThresholdStripes(frame, lower, upper, hsv, raw));
+
+	// Every pixel gets written by one of the stripes.
+	threshold.create(frame.size(), CV_8UC1);
+	cv::parallel_for_(cv::Range(0, THRESHOLD_STRIPES), MorphStripes(raw, passes, scale, threshold));
+}
+
+void startThreadPool() {
+	cv::parallel_for_(cv::Range(0, cv::getNumThreads()), NoWork());
+}
+
+IncrementalThreshold::IncrementalThreshold(int tile_size, int change_threshold, int change_pixels, int refresh_frames) {
+	this->tile_size = tile_size;
+	this->change_threshold = change_threshold;
+	this->change_pixels = change_pixels;
+	this->refresh_frames = refresh_frames;
+}
+
+IncrementalThreshold::~IncrementalThreshold() {
+}
+
+void IncrementalThreshold::reset() {
+	reference.release();
+}
+
+int IncrementalThreshold::process(const cv::Mat &frame, cv::Scalar lower, cv::Scalar upper, int passes, double scale, cv::Mat &threshold) {
+	// Start over when the frame size or any filter setting changed.
+	// Also start over every refresh_frames frames.
+	if (reference.empty() || frame.size() != reference.size() || frame.type() != reference.type()
+			|| lower != this->lower || upper != this->upper || passes != this->passes || scale != this->scale
+			|| frames_since_refresh >= refresh_frames) {
+		frames_since_refresh = 1;
+		this->lower = lower;
+		this->upper = upper;
+		this->passes = passes;
+		this->scale = scale;
+		tiles_x = (frame.cols + tile_size - 1) / tile_size;
+		tiles_y = (frame.rows + tile_size - 1) / tile_size;
+		changed.assign(tiles_x * tiles_y, 1);
+
+		frame.copyTo(reference);
+		cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
+		inRange(hsv, lower, upper, raw);
+		raw.copyTo(morphed);
+		morphOps(morphed, passes, scale);
+		reserveMorphRegion(frame.size());
+
+		threshold = morphed;
+		return getNumTiles();
+	}
+
+	frames_since_refresh++;
+
+	// Per pixel test, so a small target moving a pixel or two still marks its tile. Whole frame
+	// vectorised passes, alpha is ignored since inRange gives it the full range.
+	cv::absdiff(frame, reference, difference);
+	inRange(difference, cv::Scalar(0, 0, 0, 0), cv::Scalar(change_threshold, change_threshold, change_threshold, 255), unchanged);
+
+	// Threshold the changed tiles. The threshold is per pixel so tiles need no halo here.
+	cv::Rect bounds(0, 0, frame.cols, frame.rows);
+	int count = 0;
+	for (int ty = 0; ty < tiles_y; ty++) {
+		for (int tx = 0; tx < tiles_x; tx++) {
+			cv::Rect tile = cv::Rect(tx * tile_size, ty * tile_size, tile_size, tile_size) & bounds;
+			bool tile_changed = tile.area() - cv::countNonZero(unchanged(tile)) >= change_pixels;
+			changed[ty * tiles_x + tx] = tile_changed;
+			if (!tile_changed)
+				continue;
+
+			count++;
+			cv::Mat reference_tile = reference(tile);
+			cv::Mat hsv_tile = hsv(tile);
+			cv::Mat raw_tile = raw(tile);
+			frame(tile).copyTo(reference_tile);
+			cvtColor(frame(tile), hsv_tile, cv::COLOR_BGR2HSV);
+			inRange(hsv_tile, lower, upper, raw_tile);
+		}
+	}
+
+	// Redo morphOps wherever a changed tile can reach, one run of neighbouring tiles at a time.
+	int halo = morphHalo(passes, scale);
+	for (int ty = 0; ty < tiles_y; ty++) {
+		int tx = 0;
+		while (tx < tiles_x) {
+			if (!changed[ty * tiles_x + tx]) {
+				tx++;
+				continue;
+			}
+			int run_start = tx;
+			while (tx < tiles_x && changed[ty * tiles_x + tx])
+				tx++;
+
+			cv::Rect run = cv::Rect(run_start * tile_size, ty * tile_size, (tx - run_start) * tile_size, tile_size) & bounds;
+			morphRegion(raw, grow(run, halo, frame.size()), passes, scale, morphed);
+		}
+	}
+
+	threshold = morphed;
+	return count;
+}
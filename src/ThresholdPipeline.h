@@ -0,0 +1,111 @@
+/*
+ * ThresholdPipeline.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ubuntu
+ */
+
+#ifndef THRESHOLDPIPELINE_H_
+#define THRESHOLDPIPELINE_H_
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+// Structuring element sizes used by morphOps, in camera pixels.
+const int ERODE_SIZE = 3;
+const int DILATE_SIZE = 8;
+
+// Kernel size in processing pixels at a processing scale, rounded and at least 1. Keeps the
+// kernels covering the same camera pixels at every quality level, so a lower level does not
+// merge blobs that are separate at full quality. Integer math on the scale in percent, so the
+// compile time detector profiles get exactly the same sizes.
+constexpr int scaledKernelSizePercent(int size, int scale_percent) {
+	return (size * scale_percent + 50) / 100 < 1 ? 1 : (size * scale_percent + 50) / 100;
+}
+int scaledKernelSize(int size, double scale);
+
+// Erode and dilate passes, with the kernels scaled to the processing scale of the threshold image.
+void morphOps(cv::Mat &thresh, int passes, double scale);
+
+// How far a pixel of the morphOps result can be influenced by the pixels around it. Running
+// morphOps on a region grown by this many pixels gives exactly the same result inside the
+// region as running it on the whole image.
+int morphHalo(int passes, double scale);
+
+// Compute morphOps of the raw threshold image inside out only and write it into morphed. Works
+// in a buffer of the calling thread as large as raw, allocated by the first call.
+void morphRegion(const cv::Mat &raw, cv::Rect out, int passes, double scale, cv::Mat &morphed);
+
+// Allocate the morphRegion buffer of the calling thread for images of size now.
+void reserveMorphRegion(cv::Size size);
+
+// Horizontal stripes a frame is split into for parallel processing. Fixed, so the work items do
+// not depend on the number of threads.
+const int THRESHOLD_STRIPES = 16;
+
+// cvtColor, inRange and morphOps split into horizontal stripes run in parallel on OpenCV's
+// thread pool. The result is bit identical to running them on the whole frame.
+class ParallelThreshold {
+public:
+	ParallelThreshold();
+	virtual ~ParallelThreshold();
+
+	void process(const cv::Mat &frame, cv::Scalar lower, cv::Scalar upper, int passes, double scale, cv::Mat &threshold);
+
+	cv::Mat getHSV() {return hsv;}
+
+private:
+	cv::Mat hsv;
+	cv::Mat raw;
+};
+
+// Start the worker threads of OpenCV's thread pool, so they exist before the calling thread gets
+// pinned to a single core.
+void startThreadPool();
+
+// Splits the frame into tiles and only recomputes the threshold of the tiles that changed
+// since the last frame, plus the halo morphOps needs around them. Every refresh_frames frames
+// the whole frame is recomputed, so pixels drifting slowly across an HSV bound cannot keep the
+// threshold away from the serial path for good.
+class IncrementalThreshold {
+public:
+	IncrementalThreshold(int tile_size, int change_threshold, int change_pixels, int refresh_frames);
+	virtual ~IncrementalThreshold();
+
+	// Returns the number of tiles recomputed, 0 means threshold is the same as last frame.
+	int process(const cv::Mat &frame, cv::Scalar lower, cv::Scalar upper, int passes, double scale, cv::Mat &threshold);
+
+	// Forget the previous frame, the next process() recomputes every tile.
+	void reset();
+
+	// HSV image, up to date for every tile recomputed so far.
+	cv::Mat getHSV() {return hsv;}
+	int getNumTiles() {return tiles_x * tiles_y;}
+
+private:
+	int tile_size;
+	// A tile counts as changed once change_pixels of its pixels differ by more than
+	// change_threshold in any colour channel, alpha is ignored.
+	int change_threshold;
+	int change_pixels;
+	int refresh_frames;
+	int frames_since_refresh = 0;
+	int tiles_x = 0;
+	int tiles_y = 0;
+
+	cv::Scalar lower, upper;
+	int passes = -1;
+	double scale = 0;
+
+	// Frame contents each tile was last computed from.
+	cv::Mat reference;
+	// Per pixel change test of the whole frame, 255 where no colour channel changed.
+	cv::Mat difference;
+	cv::Mat unchanged;
+	cv::Mat hsv;
+	cv::Mat raw;
+	cv::Mat morphed;
+	std::vector<uchar> changed;
+};
+
+#endif /* THRESHOLDPIPELINE_H_ */